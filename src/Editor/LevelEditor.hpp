@@ -2,6 +2,7 @@
 #define LEVELEDITOR_HPP
 
 #include "../game.hpp"
+#include "../game/lib/post.hpp"
 #include "tinyfiledialogs.h"
 #include "utils.hpp"
 #include "../imgui-1.91.9b/imgui_internal.h"
@@ -61,6 +62,7 @@ struct selection {
         selection_rect += amt;
         for (auto& obj: selected_objects) {
             obj->collision += amt;
+            if (obj->Level) obj->Level->refreshObject(obj.get());
         }
     }
 
@@ -69,6 +71,7 @@ struct selection {
             const auto [x, y] = obj->collision.pos() - selection_rect.pos();
             obj->collision.x = p.x+x;
             obj->collision.y = p.y+y;
+            if (obj->Level) obj->Level->refreshObject(obj.get());
         }
 
         selection_rect.x = p.x;
@@ -111,16 +114,17 @@ public:
         void draw() const {
             if (duration > 0.0) {
                 if (duration <= 1) {
-                    DrawText(msg.data(), 20, GetScreenHeight()-30, 20, Fade(WHITE, cast(duration, float)));
+                    TextCache::instance().draw(msg.data(), 20, cast(GetScreenHeight()-30, float), 20,
+                                               Fade(WHITE, cast(duration, float)));
                     return;
                 }
                 if (duration > 4.75) {
-                    DrawText(msg.data(), 20,
-                             cast(GetScreenHeight(), double) - 30 * sqrt(1 - clamp((duration - 4.75) * 4, 0.0, 1.0)), 20,
+                    TextCache::instance().draw(msg.data(), 20,
+                             cast(GetScreenHeight() - 30 * sqrt(1 - clamp((duration - 4.75) * 4, 0.0, 1.0)), float), 20,
                              Fade(WHITE, cast(duration, float)));
                     return;
                 }
-                DrawText(msg.data(), 20, GetScreenHeight()-30, 20, WHITE);
+                TextCache::instance().draw(msg.data(), 20, cast(GetScreenHeight()-30, float), 20, WHITE);
             }
         }
     } message_display{};
@@ -136,6 +140,9 @@ public:
     bool trying_to_quit = false;
 
     bool texture_reload_state = false;
+    bool animation_reload_state = false;//an animation changed on disk, the animation manager copies them again
+    string saving_level;//the level file the last save is writing, see saveLevel()
+    bool animation_window_was_open = false;
 
     double updateTime{};
     double drawTime{};
@@ -144,6 +151,13 @@ public:
 
     shared_ptr<LevelObject> copied_object;
 
+    bool idle_rendering = true;//only draw frames when something could have changed, see needsRedraw()
+    usize redraw_frames = 3;//frames left to draw before the editor can go idle, the first frames always get drawn
+    bool was_focused = true;
+    usize idle_waits = 0;
+    static constexpr usize redraw_grace_frames = 3;//imgui needs a couple of frames after the last input to settle
+    static constexpr double watch_wait_s = 0.05;//how long an idle wait lasts while files are watched, see waitForInput()
+
 
 
     explicit LevelEditor(bool* r) : game(true), file_name{}, main_running(r) {
@@ -194,6 +208,44 @@ public:
         trying_to_quit = true;
     }
 
+    /*
+     * whether the next frame could look any different from the last one that was drawn
+     * in the editor the level only changes because of input, so without any input, play mode, previews, messages or
+     * a popup the last frame is still right and nothing has to be drawn at all
+     */
+    bool needsRedraw() {
+        const bool focused = IsWindowFocused();
+        const bool active = !idle_rendering || running || trying_to_quit || message_display.duration > 0 ||
+                            mouse_mode != mouseInputMode::NONE || Gsettings.animationWindow ||
+                            Gsettings.createAnimation || ImGui::IsAnyItemActive() || focused != was_focused ||
+                            Allocator::loadingTextures() || HotReload::instance().pending() ||
+                            FileSaver::instance().saving() || anyInput();
+        was_focused = focused;
+        if (active) redraw_frames = redraw_grace_frames;
+        else if (redraw_frames > 0) redraw_frames--;
+        return redraw_frames > 0;
+    }
+
+    /*
+     * sleeps until the window gets any event, for frames where needsRedraw() said nothing changed
+     * the buffers dont get swapped, so the last frame that was drawn just stays on the screen
+     * a changed file isnt a window event, so while files are watched it only sleeps for watch_wait_s and then checks
+     * again, otherwise a reload would wait for the mouse to move
+     */
+    void waitForInput() {
+        idle_waits++;
+        if (HotReload::instance().watching()) {
+            WaitTime(watch_wait_s);
+            PollInputEvents();
+        } else {
+            EnableEventWaiting();
+            PollInputEvents();
+            DisableEventWaiting();
+        }
+        //however long that took isnt a frame
+        FramePacer::instance().skipFrame();
+    }
+
     ~LevelEditor() {
         json data;
         data["settings"] = json();
@@ -225,6 +277,21 @@ public:
                     ImGui::StyleColorsDark();
                 }
             }
+            ImGui::Checkbox("Depth Buffer Sorting", &depth_sorting);
+            ImGui::Checkbox("Only Redraw On Change", &idle_rendering);
+            auto fps_cap = cast(FramePacer::instance().targetFps(), i32);
+            if (ImGui::SliderInt("Frame Rate Cap", &fps_cap, 0, 240, fps_cap == 0 ? "None" : "%d")) {
+                FramePacer::instance().setTargetFps(fps_cap);
+            }
+        }
+        if (ImGui::CollapsingHeader("Post Processing")) {
+            for (auto& p: PostChain::instance().getPasses()) {
+                ImGui::PushID(p.name.data());
+                ImGui::Checkbox(p.name.data(), &p.enabled);
+                ImGui::SameLine();
+                ImGui::SliderFloat("Scale", &p.scale, 0.05f, 1.0f);
+                ImGui::PopID();
+            }
         }
         ImGui::End();
     }
@@ -344,14 +411,23 @@ public:
         if (ImGui::BeginMenuBar()) {
             if (ImGui::BeginMenu("File")) {
                 if (ImGui::MenuItem("Open")) {
-                    OpenFileDialog(file_name, 512, {"*.json"}, "Open level json", "json files", "data/");
+                    OpenFileDialog(file_name, 512, {"*.json", "*.lvl"}, "Open level", "level files", "data/");
                     if (file_name[0] != '\0') {
                         game.change_level(file_name);
                     }
                 }
-                if (ImGui::MenuItem("Save")) {
+                if (ImGui::MenuItem("Save", "Ctrl+S")) {
                     saveLevel();
                 }
+                //.lvl saves a binary level, anything else saves json
+                if (ImGui::MenuItem("Save As", nullptr, false, game.current_level != nullptr)) {
+                    char new_name[512]{};
+                    SaveFileDialog(new_name, 512, {"*.json", "*.lvl"}, "Save level", "level files", file_name);
+                    if (new_name[0] != '\0') {
+                        memcpy(file_name, new_name, sizeof(file_name));
+                        saveLevel();
+                    }
+                }
                 if (ImGui::MenuItem("Close")) {
                     edited_object = nullptr;
                     obj_selection = {};
@@ -383,6 +459,14 @@ public:
                         Gsettings.properties_window = true;
                     }
                 }
+                if (ImGui::MenuItem("Bake Lightmap")) {
+                    if (!game.current_level) {
+                        message_display.reset("No level open!");
+                    } else {
+                        game.current_level->bakeLightmap();
+                        message_display.reset("Baking lightmap, it gets saved next to the level file");
+                    }
+                }
                 ImGui::EndMenu();
             }
             if (ImGui::BeginMenu("View")) {
@@ -421,6 +505,10 @@ public:
                 ImGui::TextColored(ImVec4(1, 0, 1, 1), "Average FPS: %.2f", game.average_fps);
                 ImGui::TextColored(ImVec4(1, 0, 1, 1), "1%% High: %.0f", game.high_1fps);
                 ImGui::TextColored(ImVec4(1, 0, 1, 1), "1%% Low: %.0f", game.low_1fps);
+                const FramePacingStats& pacing = FramePacer::instance().lastStats();
+                ImGui::TextColored(ImVec4(1, 0, 1, 1), "Frame jitter (ms): %.3f worst: %.3f", pacing.jitter_ms, pacing.worst_ms);
+                ImGui::TextColored(ImVec4(1, 0, 1, 1), "Busy (ms): %.2f sleep: %.2f spin: %.2f", pacing.busy_ms, pacing.sleep_ms, pacing.spin_ms);
+                ImGui::TextColored(ImVec4(1, 0, 1, 1), "Idle waits: %zu", idle_waits);
             }
 
             ImGui::NewLine();
@@ -491,6 +579,7 @@ public:
             ImGui::End();
             return;
         }
+        bool changed = false;
         auto[name, parameters] = edited_object->getParameters();
         ImGui::TextColored({0, 1, 1, 1}, "%s", name.data());
         ImGui::SeparatorEx(ImGuiSeparatorFlags_Horizontal, 5);
@@ -535,6 +624,7 @@ public:
                 ImGui::NewLine();
                 static double rounding = 1;
                 if (ImGui::Button("Round")) {
+                    changed = true;
                     r->x = round(r->x, rounding);
                     r->y = round(r->y, rounding);
                     r->w = round(r->w, rounding);
@@ -562,6 +652,7 @@ public:
                         texture_manager_ret.reset();
                     } else {
                         *t = texture_manager_ret->second;
+                        changed = true;
                         want_texture = false;
                         Gsettings.textureWindow = false;
                         texture_manager_ret.reset();
@@ -583,6 +674,7 @@ public:
                 }
                 if (wantAnimtion && animation_manager_ret != nullptr) {
                     *a = animation_manager_ret;
+                    changed = true;
                     wantAnimtion = false;
                     Gsettings.animationWindow = false;
                     animation_manager_ret.reset();
@@ -660,7 +752,11 @@ public:
             }
             ImGui::PopID();
         }
+        //anything typed into the window could have changed the object
+        if (ImGui::IsWindowFocused() && ImGui::IsAnyItemActive()) changed = true;
         ImGui::End();
+
+        if (changed && game.current_level) game.current_level->refreshObject(edited_object.get());
     }
 
     rect getScaleRect() const {
@@ -670,6 +766,17 @@ public:
         return rect{x-side_length, y-side_length, side_length, side_length};
     }
 
+    void prepareDraw() {
+        if (game.current_level) {
+            //animations can be edited from a lot of places, so just redo the static layer once the user is done with them
+            if ((animation_window_was_open && !Gsettings.animationWindow) || texture_reload_state) {
+                game.current_level->invalidateStaticLayer();
+            }
+        }
+        animation_window_was_open = Gsettings.animationWindow;
+        game.prepareDraw();
+    }
+
     void draw() {
         if (Gsettings.show_fps_extra) start = high_resolution_clock::now();
         game.draw();
@@ -711,9 +818,13 @@ public:
             if (Gsettings.textureWindow) {
 
                 texture_manager_ret = textureManager(&Gsettings.textureWindow, texture_reload_state);
+            } else {
+                //the reload finished after the texture manager was closed, the level already picked it up
+                texture_reload_state = false;
             }
             if (Gsettings.animationWindow) animation_manager_ret = animationManager(
-                                               game.delta, &Gsettings.animationWindow);
+                                               game.delta, &Gsettings.animationWindow, animation_reload_state);
+            animation_reload_state = false;
             if (Gsettings.createAnimation) UICreateAnimationWindow();
             if (Gsettings.createObject) UICreateObjectMenu();
         }
@@ -737,6 +848,20 @@ public:
 
     void update(double delta) {
         if (Gsettings.show_fps_extra) start = high_resolution_clock::now();
+        //textures being reloaded come in a few at a time, the level redoes its caches once they all have
+        if (Allocator::uploadTextures(TextureStreamer::upload_budget_ms)) texture_reload_state = true;
+        //the editor writes the levels itself, so changed levels are left alone
+        if (const HotReloadChanges changes = HotReload::instance().update(); changes.textures || changes.animations) {
+            texture_reload_state = true;
+            animation_reload_state = changes.animations;
+        }
+        //saves are written on their own thread, they only say how they went once they're done
+        for (const auto& r: FileSaver::instance().finished()) {
+            if (!r.error.empty()) {
+                AnimationRegistry::Instance().saveFailed(r.path);
+                message_display.reset("Could not save "_str + r.path.c_str() + ": " + r.error.c_str());
+            } else if (r.path == saving_level) message_display.reset("Level saved successfully");
+        }
         if (trying_to_quit) return;
         game.delta = delta;
         game.runtime += delta;
@@ -771,6 +896,7 @@ public:
                     auto mpos = getMousePos().convert_data<double>();
 
                     edited_object->collision = {edited_object->collision.pos(), mpos+game.current_level->scroll};
+                    game.current_level->refreshObject(edited_object.get());
                 }
 
                 game.editor_update(delta);
@@ -872,6 +998,8 @@ public:
                             copied_object->copy(getMousePos().convert_data<double>() + game.current_level->Scroll()));
                         obj_selection.expand(game.current_level->objects.back());
                     }
+                } else if ((IsKeyDown(KEY_LEFT_CONTROL) && IsKeyPressed(KEY_S)) || (IsKeyPressed(KEY_LEFT_CONTROL) && IsKeyDown(KEY_S))) {
+                    saveLevel();
                 } else if (IsKeyDown(KEY_DELETE)) {
                     if (obj_selection.visible && !obj_selection.selected_objects.empty()) {
                         auto o = obj_selection.selected_objects.back();
@@ -932,30 +1060,17 @@ public:
     }
 
 
+    //only a snapshot is taken here, the files are written on the FileSaver's thread so saving a big level doesnt hitch
     void saveLevel() {
         if (!game.current_level) return;
 
-        //output ALL objects to the level file
-        /*
-         * file structure:
-         * file_name: str
-         * objects: list[obj]
-         */
+        //output ALL objects to the level file, as json or as a binary level depending on its extension
         try {
-            json out;
-            out["name"] = game.current_level->getName();
-            vector<json> objs;
-            for (auto& obj: game.current_level->objects) {
-                if (obj->isDynamic()) return;
-                objs.push_back(LevelObjectRegistry::instance().toJsonFactories[obj->getRegistryID()](*obj));
-                objs.back()["type"] = obj->getRegistryID();
-            }
-            out["objects"] = objs;
-
-            ofstream outdat(file_name);
-            outdat << out.dump(4);
+            saving_level = file_name;
+            game.current_level->saveInBackground(saving_level);
+            //only the animations that changed get written again
             AnimationRegistry::Instance().saveAnimations();
-            message_display.reset("Level saved successfully");
+            message_display.reset("Saving level...");
         } catch (const exception& e) {
             message_display.reset("Could not save level: "_str + e.what());
         }
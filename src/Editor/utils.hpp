@@ -37,6 +37,34 @@ inline void OpenFileDialog
     }
 }
 
+inline void SaveFileDialog
+(char* buffer, usize buffer_size, const vector<const char*> &patterns,
+    const char* title, const char* description, const char* default_file_path = "") {//returns a file path
+    const char *filePath = tinyfd_saveFileDialog(title, default_file_path, cast(patterns.size(), int), patterns.data(),
+                                                 description);
+
+    if (filePath) {
+        strncpy(buffer, filePath, buffer_size);
+    } else {
+        buffer[0] = '\0';
+    }
+}
+
+//whether the user did anything at all (mouse, keyboard, resizing the window) since events were last polled
+inline bool anyInput() {
+    if (IsWindowResized()) return true;
+    const Vector2 mouse = GetMouseDelta();
+    const Vector2 wheel = GetMouseWheelMoveV();
+    if (mouse.x != 0 || mouse.y != 0 || wheel.x != 0 || wheel.y != 0) return true;
+    for (i32 b = MOUSE_BUTTON_LEFT; b <= MOUSE_BUTTON_BACK; b++) {
+        if (IsMouseButtonDown(b) || IsMouseButtonReleased(b)) return true;
+    }
+    for (i32 k = KEY_SPACE; k <= KEY_KB_MENU; k++) {
+        if (IsKeyDown(k) || IsKeyReleased(k)) return true;
+    }
+    return false;
+}
+
 template<Arithmetic T>
 v2<T> screenToWorld(v2<T> v) {
     return (v-win_pos.convert_data<T>())/win_scale;
@@ -143,8 +171,13 @@ optional<pair<str, Texture2D>> textureManager(bool* open, bool& reload_state) {
         reload_state = false;
     }
 
-    if (ImGui::Button("Reload Textures")) Allocator::reloadTextures(false, reload_state);
-    if (ImGui::Button("Force Reload Textures")) Allocator::reloadTextures(true, reload_state);
+    //reload_state gets set by the editor once the streamer is done with them
+    if (ImGui::Button("Reload Textures")) Allocator::reloadTextures(false);
+    if (ImGui::Button("Force Reload Textures")) Allocator::reloadTextures(true);
+    if (Allocator::loadingTextures()) {
+        ImGui::SameLine();
+        ImGui::Text("Loading...");
+    }
 
     ImGui::BeginChild("Textures", ImVec2(half - space * 0.5f, 0), true);
     static char buf[512];
@@ -196,7 +229,8 @@ optional<pair<str, Texture2D>> textureManager(bool* open, bool& reload_state) {
 }
 
 
-shared_ptr<animation> animationManager(double delta, bool* open = nullptr) {
+//reload copies the animations out of the registry again
+shared_ptr<animation> animationManager(double delta, bool* open = nullptr, const bool reload = false) {
     ImGui::Begin("Animation Manager", open);
 
     ImVec2 contentSize = ImGui::GetContentRegionAvail();
@@ -214,7 +248,7 @@ shared_ptr<animation> animationManager(double delta, bool* open = nullptr) {
 
     ImGui::BeginChild("Animations", ImVec2(half - space * 0.5f, 0), true);
 
-    if (ImGui::Button("Reload")) anims = AnimationRegistry::Instance().getAnimations();
+    if (ImGui::Button("Reload") || reload) anims = AnimationRegistry::Instance().getAnimations();
     static char buf[512];
     ImGui::InputText("Search", buf, 512);
     str b = buf;
@@ -0,0 +1,44 @@
+#include "AustinUtils.hpp"
+#include "raylib.h"
+#include "game/lib/asset_pack.hpp"
+
+using namespace AustinUtils;
+
+/*
+ * packs every texture in resources and every animation in data/animation into one asset pack the game maps at startup
+ * run it from the same directory as the game
+ * usage: AssetPacker [--raw] [pack path]
+ * --raw keeps the pngs instead of decoding them, the pack is smaller but the game has to decode them when it starts
+ */
+int main(const int argc, char** argv) {
+    auto LPacker = logger("packer");
+    bool decode = true;
+    string out = AssetPack::default_path;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--raw") == 0) decode = false;
+        else out = argv[i];
+    }
+    SetTraceLogLevel(LOG_WARNING);
+
+    try {
+        AssetPackWriter pack(out);
+        usize textures = 0, animations = 0;
+        for (const auto& entry: filesystem::recursive_directory_iterator("resources")) {
+            if (!entry.is_regular_file() || entry.path().extension() != ".png") continue;
+            pack.addImage(entry.path().generic_string(), decode);
+            textures++;
+        }
+        for (const auto& entry: filesystem::directory_iterator("data/animation")) {
+            if (!entry.is_regular_file() || entry.path().extension() != ".json") continue;
+            pack.addFile(entry.path().generic_string(), AssetType::ANIMATION);
+            animations++;
+        }
+        pack.finish();
+        LPacker.info("Packed ", textures, " textures", decode ? " (decoded)" : "", " and ", animations, " animations into ",
+                     out, " (", filesystem::file_size(out) / 1024, " KB)");
+    } catch (const exception& e) {
+        LPacker.warn("Could not pack assets: ", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -13,13 +13,14 @@ void register_keybinds() {
     settings::KeybindRegistry::instance().registerKeybind("move_right", KEY_D, -1, "Moves the player right");
     settings::KeybindRegistry::instance().registerKeybind("move_down", KEY_S, -1, "Moves the player down");
     settings::KeybindRegistry::instance().registerKeybind("debug_mode", KEY_F3, -1, "Switches debug mode on/off");
+    settings::KeybindRegistry::instance().registerKeybind("palette_swap", KEY_F6, -1, "Switches to the next palette swap");
 }
 
 Game::Game() {
     //all keybindings should be registered here, after the game is made,
     //settings will be initialized and adding new keybind registries will not work
     register_keybinds();
-    current_level = make_unique<level>("data/level/example.json");
+    current_level = make_unique<level>("data/level/example.json", bake_lightmaps_on_load);
 }
 
 Game::Game(const bool editor) : editor_mode(editor) {
@@ -37,12 +38,58 @@ void Game::endPlay() {
 }
 
 
+void Game::prepareDraw() {
+    //the palette is only touched on the main thread, update() just asks for the swap
+    if (std::exchange(next_palette_swap, false) && IndexedColor::instance().on()) {
+        IndexedColor::instance().nextSwap();
+        LGame.info("Palette swap: ", IndexedColor::instance().currentSwap());
+        //the static layer was drawn with the old palette
+        if (current_level) current_level->invalidateStaticLayer();
+    }
+    if (current_level) current_level->prepareDraw();
+
+    //the lighting stats are written while rendering, so they cant be read from update()
+    if (light_stress) {
+        stress_time += delta;
+        stress_build_ms += LightingPass::instance().lastStats().tile_build_ms;
+        stress_frames++;
+        if (stress_time >= 1) {
+            LGame.info("Light stress | lights: ", LightingPass::instance().lastStats().lights,
+                " frame (ms): ", stress_time * 1000 / cast(stress_frames, double),
+                " tile build (ms): ", stress_build_ms / cast(stress_frames, double));
+            stress_time = 0;
+            stress_build_ms = 0;
+            stress_frames = 0;
+        }
+    }
+    //the emitters only change while updating, which is done until the next launch
+    if (!particle_stress.empty()) {
+        particle_stress_time += delta;
+        particle_stress_frames++;
+        if (particle_stress_time >= 1) {
+            usize particles = 0;
+            for (const auto& e: particle_stress) {
+                if (const auto emitter = e.lock()) particles += emitter->particleCount();
+            }
+            LGame.info("Particle stress | particles: ", particles,
+                " frame (ms): ", particle_stress_time * 1000 / cast(particle_stress_frames, double),
+                " update (ms): ", FramePipeline::instance().lastStats().update_ms);
+            particle_stress_time = 0;
+            particle_stress_frames = 0;
+        }
+    }
+}
+
 void Game::draw() {
     if (current_level) current_level->draw({});
 
     if (debug) debug_draw();
 }
 
+void Game::drawLighting() {
+    if (current_level) current_level->drawLighting({});
+}
+
 void Game::debug_draw() {
     if (current_level) current_level->debugDrawCollision();
 }
@@ -51,38 +98,193 @@ void Game::editor_update(double delta) {
     if (IsKeybindPressed(settings::get_kb("debug_mode"))) {
         debug = !debug;
     }
+    if (IsKeybindPressed(settings::get_kb("palette_swap"))) next_palette_swap = true;
 }
 
 
 void Game::drawUI() {
-
-    if (debug) {
-        //draw the frame profiler
-        DrawText(("FPS |"_str + " current: " + str(smoothed_fps, 0) + " average: " +
-            str(average_fps, 0) + " low 1%: " + str(low_1fps, 0) + " high 1%: " + str(high_1fps, 0))
-            .data(), 20, 20, 20, MAGENTA);
-        //draw level scrolling
-        if (current_level) DrawText(("Level scroll | "_str + current_level->Scroll()).data(), 20, 37, 20, MAGENTA);
+    static vector<TextCommand> ui;//kept around so its commands get reused
+    recordUI(ui);
+    for (const auto& t: ui) {
+        TextCache::instance().draw(t.text.view(), cast(t.x, float), cast(t.y, float), t.size, t.color, t.font);
     }
+}
 
 
-
-
+void Game::recordUI(vector<TextCommand>& ui) {
+    ui.clear();
+    if (debug) {
+        //every line is built straight into its command, no strings get made for them
+        const auto line = [&ui](const i32 y) -> FixedText<192>& {
+            TextCommand& t = ui.emplace_back();
+            t.x = 20;
+            t.y = y;
+            t.color = MAGENTA;
+            return t.text;
+        };
+        //the frame profiler
+        line(20).append("FPS | current: ").append(smoothed_fps, 0).append(" average: ").append(average_fps, 0)
+            .append(" low 1%: ").append(low_1fps, 0).append(" high 1%: ").append(high_1fps, 0);
+        //level scrolling
+        if (current_level) {
+            const dvec2 scroll = current_level->Scroll();
+            line(37).append("Level scroll | <").append(scroll.x, 2).append(", ").append(scroll.y, 2).append('>');
+        }
+        //the lighting stats
+        const LightingStats& ls = LightingPass::instance().lastStats();
+        line(54).append("Lighting | lights: ").append(ls.lights).append(" shadowed: ").append(ls.shadowed_lights)
+            .append(" ambient: ").append(ls.ambient).append(" tile build (ms): ").append(ls.tile_build_ms, 3);
+        //the resolution the scene is being drawn at
+        const DynamicResolution& dr = DynamicResolution::instance();
+        line(71).append("Resolution | 1/").append(dr.factor()).append(" frame (ms): ").append(dr.frameMs(), 2)
+            .append(" cpu (ms): ").append(dr.cpuMs(), 2);
+        //how many animations went through the animation batch
+        const auto [anim_draws, anim_instances] = AnimationBatch::instance().stats();
+        line(88).append("Animation batch | draws: ").append(anim_draws).append(" instances: ").append(anim_instances)
+            .append(depth_sorting ? " (depth sorted)" : "");
+        //how much of the update ran while the last frame was rendering
+        const PipelineStats& ps = FramePipeline::instance().lastStats();
+        line(105).append("Pipeline |").append(FramePipeline::instance().threaded() ? "" : " (serial)")
+            .append(" update (ms): ").append(ps.update_ms, 2).append(" render (ms): ").append(ps.render_ms, 2)
+            .append(" overlap (ms): ").append(ps.overlap_ms, 2);
+        //how evenly frames are coming out
+        const FramePacer& fp = FramePacer::instance();
+        const FramePacingStats& fs = fp.lastStats();
+        FixedText<192>& pacing = line(122).append("Pacing | target: ");
+        if (fp.targetFps() > 0) pacing.append(fp.targetFps(), 0);
+        else pacing.append("none");
+        pacing.append(" frame (ms): ").append(fs.frame_ms, 2).append(" jitter (ms): ").append(fs.jitter_ms, 3)
+            .append(" worst (ms): ").append(fs.worst_ms, 3).append(" busy (ms): ").append(fs.busy_ms, 2);
+        //how well the text cache is doing
+        const auto [text_hits, text_misses] = TextCache::instance().stats();
+        line(139).append("Text cache | hits: ").append(text_hits).append(" layouts: ").append(text_misses);
+        //how much vram the textures that can be evicted take
+        const double resident_mb = cast(Allocator::streamedBytes(), double) / (1024 * 1024);
+        line(156).append("Textures | resident (MB): ").append(resident_mb, 1)
+            .append(" budget (MB): ").append(Allocator::textureBudget() / (1024 * 1024))
+            .append(Allocator::loadingTextures() ? " (loading)" : "");
+    }
+    //shown without debug too, otherwise nothing would say that anything is happening
+    if (loading_level) {
+        TextCommand& t = ui.emplace_back();
+        t.x = 20;
+        t.y = debug ? 173 : 20;
+        t.color = MAGENTA;
+        t.text.append("Loading level | ").append(load_progress * 100, 0).append("% objects: ").append(load_objects);
+    }
 }
 
 
 void Game::update(const double delta) {
     if (current_level) current_level->update(delta);
+
     if (IsKeybindPressed(settings::get_kb("debug_mode"))) {
         debug = !debug;
     }
+    if (IsKeybindPressed(settings::get_kb("palette_swap"))) next_palette_swap = true;
+}
+
+
+void Game::spawnLightStress(const usize count) {
+    if (!current_level) return;
+    light_stress = true;
+    debug = true;
+
+    const rect area = {current_level->Scroll() - dvec2{640, 360}, base_resolution.x * 2.0, base_resolution.y * 2.0};
+    for (usize i = 0; i < count; i++) {
+        const dvec2 center = {
+            area.x + GetRandomValue(0, cast(area.w, i32)),
+            area.y + GetRandomValue(0, cast(area.h, i32))
+        };
+        const Color c = {
+            cast(GetRandomValue(64, 255), u8), cast(GetRandomValue(64, 255), u8), cast(GetRandomValue(64, 255), u8), 255
+        };
+        current_level->spawnObject<LevelLightSource>(center, cast(GetRandomValue(32, 128), float), c,
+            cast(GetRandomValue(20, 80), u8), false);
+    }
+    LGame.info("Spawned ", count, " lights for the light stress test");
+}
+
+/*
+ * 20 emitters of 5000, updating and submitting all 100000 particles takes about 2.2ms a frame (4ms at worst) on one
+ * core of a xeon with -O3, and 5.8ms at -O0, so the cpu side fits in 60fps with lots of room
+ * the gpu side is one instanced draw of 100000 quads that hasnt been timed yet
+ */
+void Game::spawnParticleStress(const usize count) {
+    if (!current_level) return;
+    debug = true;
+
+    constexpr u32 per_emitter = 5000;
+    const rect area = {current_level->Scroll() - dvec2{640, 360}, base_resolution.x * 2.0, base_resolution.y * 2.0};
+    for (usize spawned = 0; spawned < count; spawned += per_emitter) {
+        const rect spawn_area = {
+            area.x + GetRandomValue(0, cast(area.w, i32)),
+            area.y + GetRandomValue(0, cast(area.h, i32)),
+            64, 64
+        };
+        const u32 max = cast(std::min<usize>(per_emitter, count - spawned), u32);
+        //twice as many spawns a second as particles live for, so the pool stays full
+        particle_stress.push_back(current_level->spawnObject<ParticleEmitter>(spawn_area,
+            AnimationRegistry::Instance().get("default"), ParticleSettings{}, cast(max, float) * 2, max, 1.0f, 0.25f,
+            60.0f, 0.5f, -90.0f, 360.0f, true));
+    }
+    LGame.info("Spawned ", particle_stress.size(), " emitters with ", count, " particles for the particle stress test");
+}
+
+
+void Game::hotReload(const HotReloadChanges& changes) {
+    if (!current_level) return;
+    const string current = normalizeAssetPath(current_level->path);
+    if (ranges::find(changes.levels, current) != changes.levels.end()) {
+        LGame.info("Level ", current, " changed, reloading it");
+        stream_level(current.c_str());
+        return;
+    }
+    //the static layer was drawn with the old textures
+    if (changes.textures || changes.animations) current_level->invalidateStaticLayer();
 }
 
 
 void Game::change_level(const char* new_json) {
+    loading_level.reset();
     if (new_json[0] == '\0') {
         current_level.reset();
+    } else {
+        //the new level is loaded before the old one goes, so textures they share are never evicted
+        current_level = make_unique<level>(new_json, bake_lightmaps_on_load);
+    }
+    //whatever only the old level used isnt needed anymore
+    AnimationRegistry::Instance().trimTextures(0);
+}
+
+
+void Game::stream_level(const char* new_json) {
+    load_progress = 0;
+    load_objects = 0;
+    try {
+        const auto on_progress = [this](const double progress, const usize objects) {
+            load_progress = progress;
+            load_objects = objects;
+        };
+        loading_level = level::startLoading(new_json, bake_lightmaps_on_load, on_progress);
+    } catch (const exception& e) {
+        LGame.warn("Could not load level ", new_json, ": ", e.what());
+        loading_level.reset();
+    }
+}
+
+
+void Game::updateLoading(const double budget_ms) {
+    if (!loading_level) return;
+    try {
+        if (!loading_level->loadSome(budget_ms)) return;
+    } catch (const exception& e) {
+        LGame.warn("Could not load level: ", e.what());
+        loading_level.reset();
         return;
     }
-    current_level = make_unique<level>(new_json);
+    //the new level is in before the old one goes, so textures they share are never evicted
+    current_level = std::move(loading_level);
+    current_level->start();
+    AnimationRegistry::Instance().trimTextures(0);
 }
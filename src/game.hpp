@@ -1,7 +1,11 @@
 #ifndef GAME_HPP
 #define GAME_HPP
 #include "game/lib/JOB.hpp"
+#include "game/lib/particles.hpp"
 #include "game/lib/utils.hpp"
+#include "game/lib/frame_pipeline.hpp"
+#include "game/lib/frame_pacer.hpp"
+#include "game/lib/hot_reload.hpp"
 #include "game/sprites/sprite.hpp"
 #include "game/sprites/player.hpp"
 
@@ -18,8 +22,24 @@ class Game {
 
     bool debug = false;
     bool editor_mode = false;
+    bool next_palette_swap = false;//see prepareDraw()
+
+    //stress test for the lighting, see spawnLightStress()
+    bool light_stress = false;
+    double stress_time = 0;
+    double stress_build_ms = 0;
+    usize stress_frames = 0;
+    //stress test for the particles, see spawnParticleStress()
+    vector<weak_ptr<ParticleEmitter>> particle_stress;
+    double particle_stress_time = 0;
+    usize particle_stress_frames = 0;
+    logger LGame = logger("game");
 
     unique_ptr<level> current_level;
+    //a level being loaded a few objects a frame (see stream_level), it replaces current_level once it's in
+    unique_ptr<level> loading_level;
+    double load_progress = 0;
+    usize load_objects = 0;
 
     Game();
 
@@ -35,14 +55,38 @@ class Game {
 
     void editor_update(double delta);
 
+    //anything that has to be rendered before drawing to the screen buffer (e.g. the level's static layer)
+    void prepareDraw();
+
     void draw();
 
+    //submits the current level's lights to the lighting pass
+    void drawLighting();
+
     void debug_draw();
 
     void drawUI();
 
+    //the debug overlay as text commands, so it can be drawn later (see FramePipeline)
+    void recordUI(vector<TextCommand>& ui);
+
     void change_level(const char* new_json);
 
+    //loads the level without stopping the frames, the current one keeps going until the new one is done and starts
+    void stream_level(const char* new_json);
+
+    //once a frame on the main thread, loads more of the streamed level for up to budget_ms
+    void updateLoading(double budget_ms);
+
+    //picks up files that changed on disk (see HotReload), the level starts over if its file was one of them
+    void hotReload(const HotReloadChanges& changes);
+
+    //fills the area around the view with count unbaked lights and logs how long lighting takes every second
+    void spawnLightStress(usize count);
+
+    //fills the area around the view with emitters that keep count particles alive and logs how long frames take every second
+    void spawnParticleStress(usize count);
+
     void update_fps(double delta)  {
         instant_fps = 1/delta;
 
@@ -7,6 +7,17 @@
 #include "globals.hpp"
 #include "utils.hpp"
 #include "enums.hpp"
+#include "static_layer.hpp"
+#include "animation_batch.hpp"
+#include "depth_sort.hpp"
+#include "primitives.hpp"
+#include "spatial.hpp"
+#include "lighting.hpp"
+#include "lightmap.hpp"
+#include "shadows.hpp"
+#include "level_binary.hpp"
+#include "json_schema.hpp"
+#include "level_stream.hpp"
 
 struct LevelObject;
 using namespace AustinUtils;
@@ -68,7 +79,7 @@ class level;
 
 
 template<typename T>
-concept ObjectFactory = requires(json& data)
+concept ObjectFactory = requires(const json& data)
 {
     typename T::factory_type;
     { T::createFromJson(data) } -> same_as<shared_ptr<typename T::factory_type>>;
@@ -80,6 +91,20 @@ concept ObjectFactory = requires(json& data)
     };
 };
 
+/*
+ * a factory that can also save its objects into binary levels, as a fixed size record (see level_binary.hpp)
+ * records get read straight out of the mapped file, so they can only hold plain data, strings go in the level's
+ * string table
+ */
+template<typename T>
+concept BinaryObjectFactory = ObjectFactory<T> &&
+    is_trivially_copyable_v<typename T::record> && is_standard_layout_v<typename T::record> &&
+    requires(const typename T::record& r, const BinaryLevelFile& file, LevelObject& obj, BinaryLevelWriter& out)
+{
+    { T::createFromBinary(r, file) } -> same_as<shared_ptr<typename T::factory_type>>;
+    { T::objectToBinary(obj, out) } -> same_as<typename T::record>;
+};
+
 
 
 struct DynamicLevelObject;
@@ -137,7 +162,10 @@ protected:
     level* Level = nullptr;
     usize ID = -1;
 
-
+    //what the level last saw of this object, used to know which of the level's caches to update when it changes
+    rect tracked_bounds{};
+    bool tracked_static = false;
+    usize visit_stamp = 0;//so spatial queries only hand back an object once
 
 public:
 
@@ -223,17 +251,61 @@ public:
         return collision;
     }
 
+    //everything the object draws (including lighting) has to be inside of this, it always contains the collision
+    virtual rect bounds() {
+        return collision;
+    }
+
+    //adds the collision to PrimitiveBatch::debug(), the level flushes it
     virtual void debugDrawCollision(const dvec2 offset) {
-        DrawRectangleLinesEx(collision-offset, 2, debug_colors[cast(eCollision, usize)]);
-        DrawCircle(
-            EXPAND_V((collision.pos()-offset).convert_data<i32>()), 2,
-            debug_colors[cast(eCollision, usize)]);
+        auto& batch = PrimitiveBatch::debug();
+        batch.rectangleLines(collision-offset, 2, debug_colors[cast(eCollision, usize)]);
+        batch.circle(collision.pos()-offset, 2, debug_colors[cast(eCollision, usize)]);
     }
 
+    //adds the object's drop shadow to PrimitiveBatch::shadows(), the level draws every shadow over the floors and under every other object
+    virtual void submitShadow(dvec2 offset) {}
+
     virtual double depth() {
         return collision.y + collision.h;
     }
 
+    //if true the object gets drawn once into the level's static layer instead of every frame,
+    //only return true if draw() always gives the same result and the object is always underneath everything else
+    virtual bool isStaticLayer() {
+        return false;
+    }
+
+    //if true the object's drawLighting() never changes at runtime, so the level can bake it into its lightmap
+    virtual bool bakesLighting() {
+        return false;
+    }
+
+    //called by the level when something that blocks light was added, moved or removed inside of the object's bounds
+    virtual void occludersChanged() {}
+
+    //what the object mostly draws with, with depth sorting on objects with the same key get drawn one after another
+    //so raylib can batch them
+    virtual u32 batchKey() {
+        return 0;
+    }
+
+    //the animation the object's json points to with "texture", empty if it doesnt, binary levels load these up front
+    virtual str referencedAnimation() {
+        return {};
+    }
+
+    //true if the object draws anything partly see through, those cant go in the depth buffer
+    virtual bool isTranslucent() {
+        return false;
+    }
+
+    //draws the object by adding it to the AnimationBatch instead of drawing it right away,
+    //returns false if the object cant be batched and needs draw() instead
+    virtual bool drawBatched(dvec2 offset) {
+        return false;
+    }
+
     //run when the sprite spawns
     virtual void OnSpawn() {
 
@@ -256,9 +328,13 @@ public:
 class LevelObjectRegistry {
 public:
     unordered_set<str> IDS;
-    unordered_map<str, function<shared_ptr<LevelObject>(json& dat)>> factories;
+    unordered_map<str, function<shared_ptr<LevelObject>(const json& dat)>> factories;
     unordered_map<str, function<shared_ptr<LevelObject>()>> defaultFactories;
     unordered_map<str, function<json(LevelObject& l)>> toJsonFactories;
+    //only for types whose factory is a BinaryObjectFactory, anything else gets saved to binary levels as json
+    unordered_map<str, function<shared_ptr<LevelObject>(const byte* record, const BinaryLevelFile& file)>> binaryFactories;
+    unordered_map<str, function<void(LevelObject& l, BinaryLevelWriter& out)>> toBinaryFactories;
+    unordered_map<str, u32> binaryRecordSizes;
 
     static LevelObjectRegistry& instance() {
         static LevelObjectRegistry inst;
@@ -274,13 +350,52 @@ public:
         factories[type_id] = T::createFromJson;
         defaultFactories[type_id] = T::createDefault;
         toJsonFactories[type_id] = T::objectToJson;
+        if constexpr (BinaryObjectFactory<T>) {
+            using record = typename T::record;
+            binaryFactories[type_id] = [](const byte* r, const BinaryLevelFile& file) -> shared_ptr<LevelObject> {
+                return T::createFromBinary(*reinterpret_cast<const record*>(r), file);
+            };
+            toBinaryFactories[type_id] = [id = type_id.stdStr()](LevelObject& obj, BinaryLevelWriter& out) {
+                out.add(id, T::objectToBinary(obj, out));
+            };
+            binaryRecordSizes[type_id] = sizeof(record);
+        }
         return type_id;
     }
 
 
-    shared_ptr<LevelObject> create(const str& type_id, json& data) {
+    shared_ptr<LevelObject> create(const str& type_id, const json& data) {
+        const auto it = factories.find(type_id);
+        if (it == factories.end()) throw Exception("Cannot create type ", type_id);
+        return it->second(data);
+    }
+
+    json toJson(LevelObject& obj) {
+        json ret = toJsonFactories[obj.getRegistryID()](obj);
+        ret["type"] = obj.getRegistryID();
+        return ret;
+    }
+
+    void toBinary(LevelObject& obj, BinaryLevelWriter& out) {
+        const str type_id = obj.getRegistryID();
+        if (const auto it = toBinaryFactories.find(type_id); it != toBinaryFactories.end()) it->second(obj, out);
+        else out.addJson(type_id.stdStr(), toJson(obj));
+    }
+
+    //what creates the objects of one of a binary level's types, worked out once per type instead of once per object
+    function<shared_ptr<LevelObject>(const byte*)> binaryReader(const BinaryLevelFile& file, const BinaryTypeEntry& type) {
+        const str type_id = string(file.text(type.id));
         if (!factories.contains(type_id)) throw Exception("Cannot create type ", type_id);
-        return factories[type_id](data);
+        if (type.json) {
+            return [this, &file, type_id](const byte* r) {
+                return create(type_id, json::parse(file.text(*reinterpret_cast<const BinaryString*>(r))));
+            };
+        }
+        const auto it = binaryFactories.find(type_id);
+        if (it == binaryFactories.end() || binaryRecordSizes[type_id] != type.record_size) {
+            throw Exception("Binary records of type ", type_id, " dont match its factory, resave the level from json");
+        }
+        return [&file, factory = it->second](const byte* r) { return factory(r, file); };
     }
 };
 
@@ -292,28 +407,20 @@ struct LevelObjectFactory {
 
     using factory_type = LevelObject;
 
-    NODISCARD static shared_ptr<factory_type> createFromJson(json& data) {
-        rect c = rect();
-        auto eC = collisionType::NO_COLLISION;
-        bool w = true;
-        if (validateJsonData(data, "collision", json::value_t::array)) {
-            auto vals = data["collision"].get<vector<double>>();
-            if (vals.size() != 4) {
-                throw Exception("Cannot create collision from array of size ", vals.size());
-            }
-            c.x = vals[0];
-            c.y = vals[1];
-            c.w = vals[2];
-            c.h = vals[3];
-        }
-        if (validateJsonData(data, "collision_type", json::value_t::number_unsigned)) {
-            eC = data["collision_type"].get<collisionType>();
-        }
-        if (validateJsonData(data, "walkable", json::value_t::boolean)) {
-            w = data["walkable"].get<bool>();
-        }
+    struct fields {
+        rect collision{};
+        collisionType collision_type = collisionType::NO_COLLISION;
+        bool walkable = true;
+    };
 
-        return make_shared<factory_type>(c, eC, w);
+    inline static const JsonSchema<fields> schema = JsonSchema<fields>()
+        .field("collision", &fields::collision)
+        .field("collision_type", &fields::collision_type, {0, 3})
+        .field("walkable", &fields::walkable);
+
+    NODISCARD static shared_ptr<factory_type> createFromJson(const json& data) {
+        const fields f = schema.read(data);
+        return make_shared<factory_type>(f.collision, f.collision_type, f.walkable);
     }
 
     NODISCARD static shared_ptr<factory_type> createDefault() {
@@ -329,7 +436,21 @@ struct LevelObjectFactory {
         return ret;
     }
 
+    struct record {
+        BinaryRect collision;
+        u32 collision_type;
+        bool walkable;
+        array<u8, 3> unused{};//the padding, spelled out so it's saved as zeros
+    };
+    static_assert(sizeof(record) == 40);
+
+    NODISCARD static shared_ptr<factory_type> createFromBinary(const record& r, const BinaryLevelFile&) {
+        return make_shared<factory_type>(r.collision.toRect(), cast(r.collision_type, collisionType), r.walkable);
+    }
 
+    NODISCARD static record objectToBinary(LevelObject& obj, BinaryLevelWriter&) {
+        return {BinaryRect::of(obj.getCollision()), cast(obj.CollisionType(), u32), obj.Walkable()};
+    }
 };
 
 #define REGISTER(TYPE, ID) inline str TYPE::registered = LevelObjectRegistry::instance().addEntry<TYPE##Factory>(ID);
@@ -343,25 +464,57 @@ private:
     float radius;
     Color c;
     u8 light_level;
+    bool baked = true;//lights that get changed at runtime should turn this off
+    bool shadows = true;
+    float shadow_softness = 0;//how big the light is, 0 gives hard shadows
+
+    //the visibility polygons the light was last drawn with, only rebuilt when the light or the walls around it change
+    struct {
+        bool valid = false;
+        bool occluded = false;//nothing nearby blocks the light, so it can be drawn without any polygons
+        dvec2 center;
+        float radius = 0;
+        float softness = 0;
+        vector<dvec2> samples;
+        vector<vector<dvec2>> polygons;//one for every sample
+    } shadow_cache;
+
+    //the points the light is sampled from, more than one for soft shadows
+    vector<dvec2> samplePoints() const {
+        const dvec2 center = collision.pos();
+        if (shadow_softness <= 0) return {center};
+        const double s = shadow_softness;
+        return {center, center + dvec2{s, 0}, center - dvec2{s, 0}, center + dvec2{0, s}, center - dvec2{0, s}};
+    }
 
 public:
     LevelLightSource() : LevelObject({0, 0, 32, 32}, collisionType::NO_COLLISION, true), radius(0), c(), light_level() {}
 
-    LevelLightSource(dvec2 center, const float radius, const Color lc, u8 level) :
+    LevelLightSource(dvec2 center, const float radius, const Color lc, u8 level, const bool baked = true,
+                     const bool shadows = true, const float shadow_softness = 0) :
     LevelObject({center, 32 ,32}, collisionType::NO_COLLISION, true), radius(radius), c(lc),
-    light_level(level) {}
+    light_level(level), baked(baked), shadows(shadows), shadow_softness(shadow_softness) {}
 
-    void drawLighting(dvec2 offset) override {
-        DrawCircleGradient(cast(collision.x-offset.x, int), cast(collision.y-offset.y, int), radius,
-            Fade(c, cast(light_level, float)/255.0f),
-            Fade(c, 0.003));
-        //DrawCircle(cast(collision.x-offset.x, int), cast(collision.y-offset.y, int), radius, RED);
+    //defined after level since it needs the level's occluders
+    void drawLighting(dvec2 offset) override;
+
+    void occludersChanged() override {
+        shadow_cache.valid = false;
+    }
+
+    rect bounds() override {
+        const double r = abs(radius);
+        return collision | rect{collision.x - r, collision.y - r, r*2, r*2};
+    }
+
+    bool bakesLighting() override {
+        return baked;
     }
 
 
 
     shared_ptr<LevelObject> copy(dvec2 pos) override {
-        return make_shared<LevelLightSource>(collision.pos(), radius, c, light_level);
+        return make_shared<LevelLightSource>(collision.pos(), radius, c, light_level, baked, shadows, shadow_softness);
     }
 
     pair<str, vector<ObjectParameter>> getParameters() override {
@@ -370,7 +523,10 @@ public:
         {
                 ObjectParameter{"Radius", OPType::FLOAT32, &radius, -1.0/0.0, 1.0/0.0},
                 ObjectParameter{"Color", OPType::COLOR, &c},
-                ObjectParameter{"Light Level", OPType::UNSIGNED_INTEGER8, &light_level, 0, 255}
+                ObjectParameter{"Light Level", OPType::UNSIGNED_INTEGER8, &light_level, 0, 255},
+                ObjectParameter{"Baked", OPType::BOOLEAN, &baked},
+                ObjectParameter{"Shadows", OPType::BOOLEAN, &shadows},
+                ObjectParameter{"Shadow Softness", OPType::FLOAT32, &shadow_softness, 0, 64}
             }
         };
     }
@@ -379,35 +535,29 @@ public:
 struct LevelLightSourceFactory {
     using factory_type = LevelLightSource;
 
-    NODISCARD static shared_ptr<factory_type> createFromJson(json& data) {
-        dvec2 pos;
-        Color c;
-        float radius;
-        u8 light_level;
-
-        if (validateJsonData(data, "pos", json::value_t::array)) {
-            auto v = data["pos"].get<vector<double>>();
-            if (v.size() != 2) throw Exception("Cannot make LevelLightSource with json data");
-
-            pos.x = v[0];
-            pos.y = v[1];
-        }
-        if (validateJsonData(data, "color", json::value_t::array)) {
-            auto v = data["color"].get<vector<u8>>();
-            if (v.size() != 3) throw Exception("Cannot make LevelLightSource with json data");
+    struct fields {
+        dvec2 pos{};
+        Color color = {0, 0, 0, 255};
+        float radius = 0;
+        u8 light_level = 0;
+        bool baked = true;
+        bool shadows = true;
+        float shadow_softness = 0;
+    };
 
-            c.r = v[0];
-            c.g = v[1];
-            c.b = v[2];
-        }
-        if (validateJsonData(data, "light_level", json::value_t::number_unsigned)) {
-            light_level = data["light_level"].get<u8>();
-        }
-        if (validateJsonData(data, "radius", JSON_NUMBERS)) {
-            radius = data["radius"].get<float>();
-        }
+    inline static const JsonSchema<fields> schema = JsonSchema<fields>()
+        .field("pos", &fields::pos)
+        .field("color", &fields::color)
+        .field("radius", &fields::radius)
+        .field("light_level", &fields::light_level)
+        .field("baked", &fields::baked)
+        .field("shadows", &fields::shadows)
+        .field("shadow_softness", &fields::shadow_softness, {0});
 
-        return make_shared<factory_type>(pos, radius, c, light_level);
+    NODISCARD static shared_ptr<factory_type> createFromJson(const json& data) {
+        const fields f = schema.read(data);
+        return make_shared<factory_type>(f.pos, f.radius, f.color, f.light_level, f.baked, f.shadows,
+                                         f.shadow_softness);
     }
 
     NODISCARD static shared_ptr<factory_type> createDefault() {
@@ -422,10 +572,35 @@ struct LevelLightSourceFactory {
         res["color"] = {obj.c.r, obj.c.g, obj.c.b};
         res["radius"] = obj.radius;
         res["light_level"] = obj.light_level;
+        res["baked"] = obj.baked;
+        res["shadows"] = obj.shadows;
+        res["shadow_softness"] = obj.shadow_softness;
 
         return res;
     }
 
+    struct record {
+        double x, y;
+        Color color;
+        float radius;
+        float shadow_softness;
+        u8 light_level;
+        bool baked;
+        bool shadows;
+        u8 unused = 0;//the padding, spelled out so it's saved as zeros
+    };
+    static_assert(sizeof(record) == 32);
+
+    NODISCARD static shared_ptr<factory_type> createFromBinary(const record& r, const BinaryLevelFile&) {
+        return make_shared<factory_type>(dvec2{r.x, r.y}, r.radius, r.color, r.light_level, r.baked, r.shadows,
+                                         r.shadow_softness);
+    }
+
+    NODISCARD static record objectToBinary(LevelObject& x, BinaryLevelWriter&) {
+        const LevelLightSource& obj = *dynamic_cast<LevelLightSource *>(&x);
+        return {obj.collision.x, obj.collision.y, obj.c, obj.radius, obj.shadow_softness, obj.light_level, obj.baked,
+                obj.shadows};
+    }
 };
 
 REGISTER(LevelLightSource, "level_light_source")
@@ -459,11 +634,26 @@ public:
 
 
     void draw(const dvec2 offset) override {
+        IndexedColor::instance().use(floor_texture->getTexture());
         DrawAnimation(*floor_texture, collision.pure(), collision - offset);
     }
 
+    bool drawBatched(const dvec2 offset) override {
+        if (!floor_texture->isStateless()) return false;
+        AnimationBatch::instance().add(*floor_texture, collision - offset);
+        return true;
+    }
+
+    u32 batchKey() override {
+        return floor_texture->getTexture().id;
+    }
+
+    str referencedAnimation() override {
+        return floor_texture->getId();
+    }
+
     void drawLighting(const dvec2 offset) override {
-        DrawRectangle(EXPAND_R(collision-offset), Fade(BLACK, cast(255-light, float)/255));
+        LightingPass::instance().addAmbient(collision - offset, light);
     }
 
     shared_ptr<LevelObject> copy(const dvec2 pos) override {
@@ -473,6 +663,14 @@ public:
     double depth() override {
         return -(1.0/0.0);
     }
+
+    bool isStaticLayer() override {
+        return floor_texture->isStatic();
+    }
+
+    bool bakesLighting() override {
+        return true;
+    }
 };
 
 
@@ -481,30 +679,20 @@ struct LevelFloorFactory {
 
     using factory_type = LevelFloor;
 
-    NODISCARD static shared_ptr<factory_type> createFromJson(json& data) {
-        rect c = rect();
-        str t = "default";
+    struct fields {
+        rect area{};
+        str texture = "default";
         u8 light_level = 255;
-        if (validateJsonData(data, "area", json::value_t::array)) {
-            auto vals = data["area"].get<vector<double>>();
-            if (vals.size() != 4) {
-                throw Exception("Cannot create collision from array of size ", vals.size());
-            }
-            c.x = vals[0];
-            c.y = vals[1];
-            c.w = vals[2];
-            c.h = vals[3];
-        } else {
-            throw Exception("Could not make Level Floor from json data");
-        }
-        if (validateJsonData(data, "texture", json::value_t::string)) {
-            t = data["texture"].get<string>();
-        }
-        if (validateJsonData(data, "light_level", json::value_t::number_unsigned)) {
-            light_level = data["light_level"].get<u8>();
-        }
+    };
+
+    inline static const JsonSchema<fields> schema = JsonSchema<fields>()
+        .required("area", &fields::area)
+        .field("texture", &fields::texture)
+        .field("light_level", &fields::light_level);
 
-        return make_shared<factory_type>(c, AnimationRegistry::Instance().get(t), light_level);
+    NODISCARD static shared_ptr<factory_type> createFromJson(const json& data) {
+        const fields f = schema.read(data);
+        return make_shared<factory_type>(f.area, AnimationRegistry::Instance().get(f.texture), f.light_level);
     }
 
     NODISCARD static shared_ptr<factory_type> createDefault() {
@@ -520,6 +708,23 @@ struct LevelFloorFactory {
         return ret;
     }
 
+    struct record {
+        BinaryRect area;
+        BinaryString texture;
+        u8 light_level;
+        array<u8, 7> unused{};//the padding, spelled out so it's saved as zeros
+    };
+    static_assert(sizeof(record) == 48);
+
+    NODISCARD static shared_ptr<factory_type> createFromBinary(const record& r, const BinaryLevelFile& file) {
+        return make_shared<factory_type>(r.area.toRect(), AnimationRegistry::Instance().get(string(file.text(r.texture))),
+                                         r.light_level);
+    }
+
+    NODISCARD static record objectToBinary(LevelObject& x, BinaryLevelWriter& out) {
+        const auto* obj = dynamic_cast<LevelFloor*>(&x);
+        return {BinaryRect::of(obj->getCollision()), out.addString(obj->floor_texture->getId().stdStr()), obj->light};
+    }
 };
 
 REGISTER(LevelFloor, "level_floor")
@@ -548,8 +753,9 @@ public:
         tint = WHITE;
     }
 
+    //looping animations get their frame from the animation batch's clock instead
     void update(seconds_t delta) override {
-        texture->update(delta);
+        if (!texture->isStateless()) texture->update(delta);
     }
 
     shared_ptr<animation> getAnimation() const {
@@ -561,9 +767,33 @@ public:
     }
 
     void draw(dvec2 offset) override {
+        IndexedColor::instance().use(texture->getTexture());
         DrawAnimation(*texture, collision.pure(), collision-offset, tint);
     }
 
+    bool drawBatched(const dvec2 offset) override {
+        if (!texture->isStateless()) return false;
+        AnimationBatch::instance().add(*texture, collision - offset, tint);
+        return true;
+    }
+
+    u32 batchKey() override {
+        return texture->getTexture().id;
+    }
+
+    str referencedAnimation() override {
+        return texture->getId();
+    }
+
+    bool isTranslucent() override {
+        return tint.a < 255 || texture->isTranslucent();
+    }
+
+    //only flat props that get walked over can be cached, anything else has to be depth sorted with the sprites
+    bool isStaticLayer() override {
+        return walkable && eCollision != collisionType::BLOCK_ALL && texture->isStatic();
+    }
+
     pair<str, vector<ObjectParameter>> getParameters() override {
         auto params = LevelObject::getParameters();
         params.second.push_back(ObjectParameter{"Animation", OPType::ANIMATION, &texture});
@@ -577,54 +807,25 @@ public:
 struct LevelPropFactory {
     using factory_type = LevelProp;
 
-    NODISCARD static shared_ptr<factory_type> createFromJson(json& data) {
-        rect c = rect();
-        auto eC = collisionType::NO_COLLISION;
-        bool w = true;
+    struct fields {
+        rect collision{};
+        collisionType collision_type = collisionType::NO_COLLISION;
+        bool walkable = true;
         Color tint = WHITE;
-        shared_ptr<animation> anim;
-        if (validateJsonData(data, "collision", json::value_t::array)) {
-            auto vals = data["collision"].get<vector<double>>();
-            if (vals.size() != 4) {
-                throw Exception("Cannot create collision from array of size ", vals.size());
-            }
-            c.x = vals[0];
-            c.y = vals[1];
-            c.w = vals[2];
-            c.h = vals[3];
-        }
-        if (validateJsonData(data, "collision_type", json::value_t::number_unsigned)) {
-            eC = data["collision_type"].get<collisionType>();
-        }
-        if (validateJsonData(data, "walkable", json::value_t::boolean)) {
-            w = data["walkable"].get<bool>();
-        }
-        if (validateJsonData(data, "tint", json::value_t::array)) {
+        str texture;
+    };
 
-            try {
-                auto vals = data["tint"].get<vector<u8>>();
-                if (vals.size() != 3) throw Exception("Cannot create level prop from json data");
-                tint.r = vals[0];
-                tint.g = vals[1];
-                tint.b = vals[2];
-            } catch (exception& e) {
-                try {
-                    auto vals = data["tint"].get<vector<float>>();
-                    tint.r = cast(clamp(vals[0], 0, 1)*255, u8);
-                    tint.g = cast(clamp(vals[1], 0, 1)*255, u8);
-                    tint.b = cast(clamp(vals[2], 0, 1)*255, u8);
-                } catch (exception& e2) {
-                    throw Exception("Cannot create level prop from json data");
-                }
-            }
-        }
-        if (validateJsonData(data, "texture", json::value_t::string)) {
-            anim = AnimationRegistry::Instance().get(data["texture"].get<string>());
-        } else {
-            throw Exception("Cannot create level prop from json data");
-        }
+    inline static const JsonSchema<fields> schema = JsonSchema<fields>()
+        .field("collision", &fields::collision)
+        .field("collision_type", &fields::collision_type, {0, 3})
+        .field("walkable", &fields::walkable)
+        .field("tint", &fields::tint)
+        .required("texture", &fields::texture);
 
-        return make_shared<factory_type>(anim, c, eC, tint, w);
+    NODISCARD static shared_ptr<factory_type> createFromJson(const json& data) {
+        const fields f = schema.read(data);
+        return make_shared<factory_type>(AnimationRegistry::Instance().get(f.texture), f.collision, f.collision_type,
+                                         f.tint, f.walkable);
     }
 
     NODISCARD static shared_ptr<factory_type> createDefault() {
@@ -643,6 +844,26 @@ struct LevelPropFactory {
         return ret;
     }
 
+    struct record {
+        BinaryRect collision;
+        BinaryString texture;
+        u32 collision_type;
+        Color tint;
+        bool walkable;
+        array<u8, 7> unused{};//the padding, spelled out so it's saved as zeros
+    };
+    static_assert(sizeof(record) == 56);
+
+    NODISCARD static shared_ptr<factory_type> createFromBinary(const record& r, const BinaryLevelFile& file) {
+        return make_shared<factory_type>(AnimationRegistry::Instance().get(string(file.text(r.texture))),
+                                         r.collision.toRect(), cast(r.collision_type, collisionType), r.tint, r.walkable);
+    }
+
+    NODISCARD static record objectToBinary(LevelObject& x, BinaryLevelWriter& out) {
+        auto* obj = dynamic_cast<LevelProp*>(&x);
+        return {BinaryRect::of(obj->getCollision()), out.addString(obj->getAnimation()->getId().stdStr()),
+                cast(obj->CollisionType(), u32), obj->tint, obj->Walkable()};
+    }
 };
 
 
@@ -708,43 +929,393 @@ private:
     logger LLevel;
     bool started = false;
 
+    //the static layer is cached in two parts, the floors that aren't cached get drawn between them so they cant cover
+    //a cached prop
+    StaticLayerCache floor_layer;
+    StaticLayerCache prop_layer;
+    SpatialGrid<LevelObject> grid;
+    usize query_stamp = 0;
+    vector<LevelObject*> visible;//reused every time we cull so we dont reallocate every frame
+
+    string path;//the file the level was loaded from, the lightmap is stored next to it
+    Lightmap lightmap;
+    bool lightmap_dirty = false;//something baked changed, the lightmap has to be checked against the level again
+    bool bake_pending = false;
+
+    unique_ptr<LevelStream> loader;//while the level is still being loaded a few objects a frame, see loadSome()
+    function<void(double, usize)> on_progress;
+    bool bake_on_load = false;
+    unordered_set<str> load_references;//the animations the objects loaded so far point to
+
+    SpatialGrid<Occluder> occluder_grid;
+    unordered_map<LevelObject*, array<Occluder, 4>> occluders;//node based, so the segments never move around
+    usize occluder_stamp = 0;
+    vector<const Occluder*> nearby_occluders;
+
+    [[nodiscard]] bool inStaticLayer(LevelObject* obj) const {
+        return !obj->isDynamic() && obj->isStaticLayer();
+    }
+
+    //floors and anything else that's always underneath everything, props and drop shadows go on top of it
+    static bool isGround(LevelObject* obj) {
+        const double d = obj->depth();
+        return std::isinf(d) && d < 0;
+    }
+
+    StaticLayerCache& staticLayerOf(LevelObject* obj) {
+        return isGround(obj) ? floor_layer : prop_layer;
+    }
+
+    [[nodiscard]] static bool inLightmap(LevelObject* obj) {
+        return !obj->isDynamic() && obj->bakesLighting();
+    }
+
+    //only walls that never move block light, so their edges only have to be found once
+    [[nodiscard]] static bool isOccluder(LevelObject* obj) {
+        return !obj->isDynamic() && obj->eCollision == collisionType::BLOCK_ALL;
+    }
+
+    static rect segmentBounds(const Occluder& o) {
+        return {std::min(o.a.x, o.b.x), std::min(o.a.y, o.b.y), std::abs(o.b.x - o.a.x), std::abs(o.b.y - o.a.y)};
+    }
+
+    //tells every object (so every light) touching the area that the walls inside of it changed
+    void occludersChanged(const rect& area) {
+        query_stamp++;
+        grid.query(area, [this, &area](LevelObject* obj) {
+            if (obj->visit_stamp == query_stamp) return;
+            obj->visit_stamp = query_stamp;
+            if (obj->tracked_bounds && area) obj->occludersChanged();
+        });
+    }
+
+    void addOccluders(LevelObject* obj) {
+        auto& edges = occluders[obj] = occludersFromRect(obj->collision);
+        for (auto& e: edges) occluder_grid.insert(&e, segmentBounds(e));
+        occludersChanged(obj->collision);
+    }
+
+    void removeOccluders(LevelObject* obj) {
+        const auto it = occluders.find(obj);
+        if (it == occluders.end()) return;
+        for (auto& e: it->second) occluder_grid.remove(&e, segmentBounds(e));
+        //the edges go around the rect, so the first one starts at its top left and the second one ends at its bottom right
+        const auto& edges = it->second;
+        occludersChanged({edges[0].a, edges[1].b.x - edges[0].a.x, edges[1].b.y - edges[0].a.y});
+        occluders.erase(it);
+    }
+
+    void submitBakedLighting(const dvec2 offset) {
+        for (const auto& obj: objects) {
+            if (inLightmap(obj.get())) obj->drawLighting(offset);
+        }
+    }
+
+    //what the lightmap should have been baked from
+    u64 bakedLightingHash() {
+        return LightingPass::instance().hash([this] { submitBakedLighting({0, 0}); });
+    }
+
+    [[nodiscard]] rect bakedLightingArea() const {
+        rect area{};
+        bool first = true;
+        for (const auto& obj: objects) {
+            if (!inLightmap(obj.get())) continue;
+            area = first ? obj->tracked_bounds : area | obj->tracked_bounds;
+            first = false;
+        }
+        return area;
+    }
+
+    //starts keeping the level's caches up to date with the object
+    void track(LevelObject* obj) {
+        obj->Level = this;
+        if (obj->ID == cast(-1, usize)) obj->ID = next_id++;
+        obj->tracked_bounds = obj->bounds();
+        obj->tracked_static = inStaticLayer(obj);
+        grid.insert(obj, obj->tracked_bounds);
+        if (obj->tracked_static) staticLayerOf(obj).invalidate(obj->tracked_bounds);
+        if (inLightmap(obj)) lightmap_dirty = true;
+        if (isOccluder(obj)) {
+            addOccluders(obj);
+            //baked lights behind the wall might have changed
+            lightmap_dirty = true;
+        }
+    }
+
+    static u64 debugKey(const LevelObject* obj) {
+        return cast(reinterpret_cast<uintptr_t>(obj), u64);
+    }
+
+    void untrack(LevelObject* obj) {
+        grid.remove(obj, obj->tracked_bounds);
+        PrimitiveBatch::debug().forget(debugKey(obj));
+        if (obj->tracked_static) staticLayerOf(obj).invalidate(obj->tracked_bounds);
+        if (inLightmap(obj) || occluders.contains(obj)) lightmap_dirty = true;
+        removeOccluders(obj);
+        obj->tracked_static = false;
+    }
+
+    //finds every object whose bounds touch the area, sorted by the order they should be drawn in unless sorted is false
+    vector<LevelObject*>& gather(const rect& area, const bool sorted = true) {
+        visible.clear();
+        query_stamp++;
+        grid.query(area, [this, &area](LevelObject* obj) {
+            if (obj->visit_stamp == query_stamp) return;
+            obj->visit_stamp = query_stamp;
+            if (obj->tracked_bounds && area) visible.push_back(obj);
+        });
+        if (sorted) ranges::sort(visible, [](LevelObject* o1, LevelObject* o2) {
+            if (o1->depth() != o2->depth()) return o1->depth() < o2->depth();
+            return o1->ID < o2->ID;
+        });
+        return visible;
+    }
+
+    [[nodiscard]] rect view() const {
+        return {scroll, base_resolution.x, base_resolution.y};
+    }
+
+    //adds an object that was just loaded from the level file
+    void adopt(shared_ptr<LevelObject> obj) {
+        objects.push_back(std::move(obj));
+        objects.back()->Level = this;
+        objects.back()->ID = next_id;
+        next_id++;
+        level_collision.emplace_back(&objects.back()->collision, &objects.back()->eCollision, objects.back());
+        track(objects.back().get());
+    }
+
+    //the animation an object's json points to, empty if it doesnt
+    static str referencedAnimation(const json& obj) {
+        if (!obj.is_object()) return {};
+        const auto it = obj.find("texture");
+        if (it == obj.end() || !it->is_string()) return {};
+        return it->get<string>();
+    }
+
+    //every animation the objects' json points to
+    static vector<str> referencedAnimations(const json& objs) {
+        vector<str> ret;
+        unordered_set<str> seen;
+        for (const auto& obj: objs) {
+            str id = referencedAnimation(obj);
+            if (!id.empty() && seen.insert(id).second) ret.push_back(std::move(id));
+        }
+        return ret;
+    }
+
+    void setName(const string& level_name) {
+        name = level_name;
+        LLevel = logger(name.stdStr());
+    }
+
+    //makes the next object out of its json, the json is gone right after
+    void loadJsonObject(const json& obj) {
+        const usize index = objects.size();
+        try {
+            assertJsonData(obj, "type", json::value_t::string);
+            const string& type = obj["type"].get_ref<const string&>();
+            if (str id = referencedAnimation(obj); !id.empty()) load_references.insert(std::move(id));
+            adopt(LevelObjectRegistry::instance().create(type, obj));
+
+            LLevel.info("Created object of type [registry name]: ", type);
+        } catch (const exception& e) {
+            throw Exception("Could not load object ", index, " of level ", path, ": ", e.what());
+        }
+    }
+
+    //every object is made as soon as the parser gets to the end of it, the whole file is never in memory as json
+    void loadJson() {
+        ifstream file(path, ios::binary);
+        if (!file.is_open()) {
+            throw Exception("Could not create level from file ", path);
+        }
+        LevelJsonReader reader(path, [this](const string& level_name) { setName(level_name); }, [this](json& obj) {
+            loadJsonObject(obj);
+            return true;
+        });
+        json::sax_parse(file, &reader);
+        reader.finish();
+
+        LLevel.info("Successfully created level [", name, "] from json file, ", objects.size(), " objects");
+    }
+
+    //whatever has to wait for every object to be in
+    void finishLoading(const bool bake_lightmap) {
+        //the objects' animations change in place, so their textures are in before anything gets drawn
+        if (!load_references.empty()) {
+            AnimationRegistry::Instance().preload(vector<str>(load_references.begin(), load_references.end()));
+            load_references.clear();
+        }
+
+        if (lightmap.load(path, bakedLightingHash())) {
+            LLevel.info("Loaded baked lightmap");
+        } else if (bake_lightmap) {
+            //cant bake in here since we might be inside of a texture mode
+            bake_pending = true;
+        } else {
+            LLevel.warn("No up to date lightmap, lighting will be drawn live");
+        }
+        lightmap_dirty = false;
+    }
+
+    //every record is read straight out of the mapped file, the file is unmapped again once the objects are made
+    void loadBinary() {
+        const BinaryLevelFile file(path);
+        name = string(file.name());
+        LLevel = logger(name.stdStr());
+
+        vector<str> references;
+        for (const auto& r: file.references()) references.emplace_back(string(file.text(r)));
+        AnimationRegistry::Instance().preload(references);
+
+        vector<function<shared_ptr<LevelObject>(const byte*)>> readers;
+        for (const auto& type: file.types()) readers.push_back(LevelObjectRegistry::instance().binaryReader(file, type));
+        vector<usize> next_record(readers.size());
+        objects.reserve(file.order().size());
+        level_collision.reserve(file.order().size());
+        for (usize i = 0; i < file.order().size(); i++) {
+            const u16 type = file.order()[i];
+            try {
+                adopt(readers[type](file.record(type, next_record[type]++)));
+            } catch (const exception& e) {
+                throw Exception("Could not load object ", i, " of level ", path, ": ", e.what());
+            }
+        }
+
+        LLevel.info("Successfully created level [", name, "] from binary file, ", objects.size(), " objects of ",
+                    readers.size(), " types");
+    }
+
 public:
 
     friend Game;
     friend LevelEditor;
 
+    static constexpr double load_budget_ms = 4;//how long a frame can spend on a level loaded with startLoading()
+
     level() = default;
 
-    ~level() override = default;
+    //the debug shapes of static objects are kept around by pointer, so they cant outlive the objects
+    ~level() override {
+        PrimitiveBatch::debug().clearPersistent();
+    }
+
+    /*
+     * bake_lightmap: bakes the lightmap if the one next to the level file is missing or stale,
+     * otherwise a stale lightmap just means the level's lighting gets drawn live
+     */
+    explicit level(const char* level_file, const bool bake_lightmap = false) : path(level_file) {
+        if (BinaryLevelFile::isBinary(path)) loadBinary();
+        else loadJson();
+        finishLoading(bake_lightmap);
+    }
 
-    explicit level(const char* level_json) {
-        ifstream file(level_json);
-        if (!file.is_open()) {
-            throw Exception("Could not create level from file ", level_json);
+    /*
+     * starts loading a json level without making any of its objects, loadSome() makes them a few at a time so a huge
+     * level can load while frames keep coming out, it isnt usable until loadSome() returns true
+     * binary levels are read straight out of the mapped file and dont need it, those are loaded right away
+     * on_progress gets how much of the file was read (from 0 to 1) and how many objects there are after every loadSome()
+     */
+    static unique_ptr<level> startLoading(const char* level_file, const bool bake_lightmap = false,
+                                          function<void(double, usize)> on_progress = {}) {
+        if (BinaryLevelFile::isBinary(level_file)) {
+            auto ret = make_unique<level>(level_file, bake_lightmap);
+            if (on_progress) on_progress(1, ret->objects.size());
+            return ret;
         }
-        json data;
-        file >> data;
+        auto ret = make_unique<level>();
+        ret->path = level_file;
+        ret->bake_on_load = bake_lightmap;
+        ret->on_progress = std::move(on_progress);
+        ret->loader = make_unique<LevelStream>(ret->path);
+        return ret;
+    }
 
-        assertJsonData(data, "name", json::value_t::string);
-        name = data["name"].get<string>();
-        LLevel = logger(name.stdStr());
+    [[nodiscard]] bool loading() const {
+        return loader != nullptr;
+    }
 
-        LLevel.info("Successfully created level [", name, "] from json file");
+    //makes the objects that have been parsed for up to budget_ms, returns true once every object is in
+    bool loadSome(const double budget_ms) {
+        if (!loader) return true;
+        const auto start = chrono::steady_clock::now();
+        vector<json> batch;
+        bool more = true;
+        while (more) {
+            batch.clear();
+            more = loader->take(batch, 32);
+            if (name.empty()) {
+                if (const string level_name = loader->levelName(); !level_name.empty()) setName(level_name);
+            }
+            for (const auto& obj: batch) loadJsonObject(obj);
+            if (batch.empty() ||
+                chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() >= budget_ms) break;
+        }
+        if (!more) {
+            loader.reset();
+            finishLoading(bake_on_load);
+            LLevel.info("Successfully created level [", name, "] from json file, ", objects.size(), " objects");
+        }
+        if (on_progress) on_progress(loader ? loader->progress() : 1, objects.size());
+        return !loader;
+    }
 
-        assertJsonData(data, "objects", json::value_t::array);
-        vector<json> objs = data["objects"].get<vector<json>>();
-        for (auto& obj: objs) {
-            assertJsonData(obj, "type", json::value_t::string);
-            objects.push_back(LevelObjectRegistry::instance().create(obj["type"].get<string>(), obj));
-            objects.back()->Level = this;
-            objects.back()->ID = next_id;
-            next_id++;
-            level_collision.emplace_back(
-            &objects.back()->collision, &objects.back()->eCollision, objects.back());
+    json toJson() {
+        json out;
+        out["name"] = name;
+        vector<json> objs;
+        for (auto& obj: objects) {
+            if (obj->isDynamic()) continue;
+            objs.push_back(LevelObjectRegistry::instance().toJson(*obj));
+        }
+        out["objects"] = std::move(objs);
+        return out;
+    }
 
+    //everything a binary level file has, the records are copies so the objects can keep changing
+    BinaryLevelWriter binaryWriter() {
+        BinaryLevelWriter out(name.stdStr());
+        unordered_set<str> seen;
+        for (auto& obj: objects) {
+            if (obj->isDynamic()) continue;
+            LevelObjectRegistry::instance().toBinary(*obj, out);
+            str id = obj->referencedAnimation();
+            if (!id.empty() && seen.insert(id).second) out.addReference(id.stdStr());
+        }
+        return out;
+    }
 
-            LLevel.info("Created object of type [registry name]: ", obj["type"].get<string>());
+    /*
+     * what save() writes, taken right now, the function that writes it doesnt touch the level so it can be called from
+     * any thread (see FileSaver) while the level keeps changing
+     */
+    function<void(const string&)> saveSnapshot(const bool binary) {
+        if (binary) {
+            return [out = binaryWriter()](const string& file_path) mutable {
+                out.save(file_path);
+            };
         }
+        return [data = toJson()](const string& file_path) {
+            ofstream out(file_path);
+            if (!out.is_open()) throw Exception("Could not write level ", file_path);
+            out << data.dump(4);
+            out.close();
+            if (!out) throw Exception("Could not write level ", file_path);
+        };
+    }
+
+    //saves as a binary level if the path ends in .lvl, otherwise as json, the lightmap goes next to the new file from now on
+    void save(const string& file_path) {
+        FileSaver::writeAtomically(file_path, saveSnapshot(BinaryLevelFile::isBinary(file_path)));
+        path = file_path;
+    }
+
+    //like save(), but only the snapshot is taken now, the file gets written on the FileSaver's thread
+    void saveInBackground(const string& file_path) {
+        FileSaver::instance().save(file_path, saveSnapshot(BinaryLevelFile::isBinary(file_path)));
+        path = file_path;
     }
 
     void start() {
@@ -798,6 +1369,7 @@ public:
 
         level_collision.emplace_back(
             &objects.back()->collision, &objects.back()->eCollision, objects.back());
+        track(objects.back().get());
 
         if (started) objects.back()->OnSpawn();
 
@@ -813,6 +1385,7 @@ public:
     shared_ptr<LevelObject> createObject(const str &registryID) {
         objects.push_back(LevelObjectRegistry::instance().defaultFactories[registryID]());
         level_collision.push_back({&objects.back()->collision, &objects.back()->eCollision, objects.back()});
+        track(objects.back().get());
         return objects.back();
     }
 
@@ -820,6 +1393,7 @@ public:
     shared_ptr<LevelObject> addObject(const shared_ptr<LevelObject> &obj) {
         objects.push_back(obj);
         level_collision.push_back({&objects.back()->collision, &objects.back()->eCollision, objects.back()});
+        track(objects.back().get());
         return objects.back();
     }
 
@@ -929,6 +1503,7 @@ public:
         if (!obj_ptr->OnDeath()) {
             return;
         }
+        untrack(&*obj_ptr);
         const auto it2 = ranges::find_if(level_collision, [&obj_ptr](collision& c) {
             return c.description == &obj_ptr->collision;
         });
@@ -947,6 +1522,7 @@ public:
         if (!obj_ptr->OnDeath()) {
             return;
         }
+        untrack(&*obj_ptr);
         const auto it2 = ranges::find_if(level_collision, [&obj_ptr](collision& c) {
             return c.description == &obj_ptr->collision;
         });
@@ -970,6 +1546,7 @@ public:
     void forceDestroyObject(shared_ptr<T> obj_ptr) {
         obj_ptr->OnDeath();
 
+        untrack(&*obj_ptr);
         const auto it2 = ranges::find_if(level_collision, [&obj_ptr](collision& c) {
             return c.description == &obj_ptr->collision;
         });
@@ -987,6 +1564,7 @@ public:
     void forceDestroyObject(T* obj_ptr) {
         obj_ptr->OnDeath();
 
+        untrack(&*obj_ptr);
         const auto it2 = ranges::find_if(level_collision, [&obj_ptr](collision& c) {
             return c.description == &obj_ptr->collision;
         });
@@ -1018,35 +1596,247 @@ public:
         }
     }
 
-    void update(seconds_t delta) override {
+    /*
+     * call this whenever an object in the level was changed from the outside (mostly by the editor)
+     * so everything the level caches about the object gets updated
+     */
+    void refreshObject(LevelObject* obj) {
+        untrack(obj);
+        track(obj);
+    }
+
+    //throws away the whole static layer, for when something every object could depend on changed (like animations)
+    void invalidateStaticLayer() {
+        floor_layer.clear();
+        prop_layer.clear();
+        for (const auto& obj: objects) {
+            obj->tracked_static = inStaticLayer(obj.get());
+            if (obj->tracked_static) staticLayerOf(obj.get()).invalidate(obj->tracked_bounds);
+        }
+    }
 
-        //we gon sort the objects by their y position so objects with a higher y value get drawn after those with a lower value, thereby
-        //adding a '3D' look
-        ranges::sort(objects, [](const shared_ptr<LevelObject>& o1, const shared_ptr<LevelObject> &o2) {
-            return o1->depth() < o2->depth();
+    /*
+     * builds what a light at center can see out to radius from the walls near it
+     * returns false if none of them are close enough to block anything
+     */
+    bool visibilityPolygon(const dvec2 center, const double radius, vector<dvec2>& out) {
+        const rect area = {center.x - radius, center.y - radius, radius * 2, radius * 2};
+        nearby_occluders.clear();
+        occluder_stamp++;
+        occluder_grid.query(area, [this, &area](Occluder* o) {
+            if (o->visit_stamp == occluder_stamp) return;
+            o->visit_stamp = occluder_stamp;
+            //segments can have no width or height, so this cant use the rect overlap check
+            const rect b = segmentBounds(*o);
+            if (b.x <= area.x + area.w && b.x + b.w >= area.x && b.y <= area.y + area.h && b.y + b.h >= area.y) {
+                nearby_occluders.push_back(o);
+            }
         });
+        buildVisibilityPolygon(center, radius, nearby_occluders, out);
+        return !nearby_occluders.empty();
+    }
+
+    //bakes the level's static lighting into its lightmap the next time prepareDraw() is called
+    void bakeLightmap() {
+        bake_pending = true;
+    }
+
+    [[nodiscard]] bool hasLightmap() const {
+        return lightmap.valid();
+    }
+
+    //redraws whatever parts of the static layer are out of date, must be called outside of any texture mode
+    void prepareDraw() {
+        if (lightmap_dirty) {
+            lightmap_dirty = false;
+            //only throw the lightmap away if whatever changed actually changed the lighting
+            if (lightmap.valid() && !lightmap.matches(bakedLightingHash())) {
+                lightmap.unload();
+                LLevel.info("Lightmap is out of date, lighting will be drawn live until it is baked again");
+            }
+        }
+        if (bake_pending) {
+            bake_pending = false;
+            const rect area = bakedLightingArea();
+            if (path.empty() || area.w <= 0 || area.h <= 0) {
+                LLevel.warn("Nothing to bake a lightmap for");
+            } else {
+                try {
+                    lightmap.bake(path, area, bakedLightingHash(), [this](const dvec2 offset) {
+                        submitBakedLighting(offset);
+                    });
+                    LLevel.info("Baked lightmap");
+                } catch (const exception& e) {
+                    LLevel.warn("Could not bake lightmap: ", e.what());
+                }
+            }
+        }
+
+        rebuildStaticLayer(floor_layer, true);
+        rebuildStaticLayer(prop_layer, false);
+    }
+
+    void rebuildStaticLayer(StaticLayerCache& layer, const bool ground) {
+        const auto cached = [ground](LevelObject* obj) {
+            return obj->tracked_static && isGround(obj) == ground;
+        };
+        layer.rebuild(
+            [this, &cached](const rect& area) {
+                return ranges::any_of(gather(area), cached);
+            },
+            [this, &cached](const rect& area) {
+                for (const auto& obj: gather(area)) {
+                    if (cached(obj)) obj->draw(area.pos());
+                }
+                IndexedColor::instance().release();
+            });
+    }
+
+    void update(seconds_t delta) override {
+        AnimationBatch::instance().advance(delta);
+
         for (const auto& obj: objects) {
-            if (obj) obj->update(delta);
+            if (!obj) continue;
+            obj->update(delta);
+
+            //only dynamic objects move by themselves, everything else gets refreshed by whoever changes it
+            if (obj->isDynamic()) {
+                const rect b = obj->bounds();
+                if (!(b == obj->tracked_bounds)) {
+                    grid.move(obj.get(), obj->tracked_bounds, b);
+                    obj->tracked_bounds = b;
+                }
+            }
         }
 
     }
 
+    //only whatever is inside of the view gets drawn, so draw cost depends on whats on screen instead of level size
+
+    //looping animations get batched until something that cant be batched has to go on top of them
     void draw(dvec2 offset) override {
-        for (const auto& obj: objects) {
+        auto& batch = AnimationBatch::instance();
+        batch.resetStats();
+        floor_layer.draw(view(), scroll);
+        auto& objs = gather(view(), !depth_sorting);
+
+        if (depth_sorting) {
+            drawDepthSorted(objs);
+            return;
+        }
+        const auto draw_objects = [&](auto first, const auto last) {
+            for (; first != last; ++first) {
+                LevelObject* obj = *first;
+                if (obj->tracked_static || obj->drawBatched(scroll)) continue;
+                batch.flush();
+                obj->draw(scroll);
+            }
+        };
+        //the objects are sorted by depth, so the floors come first
+        const auto floors_end = ranges::find_if_not(objs, isGround);
+        draw_objects(objs.begin(), floors_end);
+        drawOverFloors(objs);
+        draw_objects(floors_end, objs.end());
+        batch.flush();
+        IndexedColor::instance().release();
+    }
+
+    //the cached props and then every drop shadow go on the ground, over every floor and under every other object
+    void drawOverFloors(const vector<LevelObject*>& objs) {
+        AnimationBatch::instance().flush();
+        prop_layer.draw(view(), scroll);
+        auto& shadows = PrimitiveBatch::shadows();
+        for (const auto& obj: objs) obj->submitShadow(scroll);
+        shadows.flush();
+    }
+
+    //with depth sorting they go at the floors' z so everything else still ends up in front of them, ends the ground
+    void drawOverFloorsSorted(const vector<LevelObject*>& objs) {
+        auto& sorter = DepthSorter::instance();
+        AnimationBatch::instance().flush();//the floors in it have their own z
+        sorter.push(-(1.0/0.0));
+        drawOverFloors(objs);
+        rlDrawRenderBatchActive();
+        sorter.pop();
+        sorter.endGround();
+    }
+
+    /*
+     * draws everything opaque in whatever order batches best and lets the depth buffer sort it out,
+     * only translucent objects still get sorted (and drawn afterward, back to front)
+     * the floors come before all of it and are drawn in order of their ID, see DepthSorter::beginGround
+     */
+    void drawDepthSorted(vector<LevelObject*>& objs) {
+        auto& batch = AnimationBatch::instance();
+        auto& sorter = DepthSorter::instance();
+        //the floors go first so the cached props and the shadows can be drawn over them, every translucent object ends up at the back
+        const auto floors_end = ranges::partition(objs, isGround).begin();
+        const auto translucent = ranges::partition(floors_end, objs.end(), [](LevelObject* obj) {
+            return !obj->isTranslucent();
+        }).begin();
+        const auto by_key = [](LevelObject* o1, LevelObject* o2) {
+            return o1->batchKey() < o2->batchKey();
+        };
+        //floors dont write depth so their order is what's seen where they overlap, partition shuffled it so it has to
+        //be the same every frame or overlapping floors flicker
+        ranges::stable_sort(objs.begin(), floors_end, [](LevelObject* o1, LevelObject* o2) {
+            return o1->ID < o2->ID;
+        });
+        ranges::sort(floors_end, translucent, by_key);
+        ranges::sort(translucent, objs.end(), [](LevelObject* o1, LevelObject* o2) {
+            if (o1->depth() != o2->depth()) return o1->depth() < o2->depth();
+            return o1->ID < o2->ID;
+        });
+
+        sorter.begin(scroll.y);
+        sorter.beginGround();
+        for (auto it = objs.begin(); it != objs.end(); ++it) {
+            LevelObject* obj = *it;
+            if (it == floors_end) drawOverFloorsSorted(objs);
+            if (it == translucent) {
+                batch.flush();
+                sorter.beginTranslucent();
+            }
+            if (obj->tracked_static) continue;
+            batch.setDepth(sorter.z(obj->depth()));
+            if (obj->drawBatched(scroll)) {
+                //translucent objects still have to be drawn in order
+                if (it >= translucent) batch.flush();
+                continue;
+            }
+            //floors dont write depth, so anything batched before this one has to be drawn first
+            if (it < floors_end) batch.flush();
+            sorter.push(obj->depth());
             obj->draw(scroll);
+            sorter.pop();
         }
+        if (floors_end == objs.end()) drawOverFloorsSorted(objs);
+        batch.flush();
+        sorter.end();
     }
 
+    //with an up to date lightmap only the lights that arent baked get drawn live
     void drawLighting(dvec2 offset) override {
-        for (const auto& obj: objects) {
+        lightmap.submit(scroll);
+        for (const auto& obj: gather(view())) {
+            if (lightmap.valid() && inLightmap(obj)) continue;
             obj->drawLighting(scroll);
         }
     }
 
+    //static objects only get their shapes built once, after that they're kept around until the object changes
     void debugDrawCollision() {
-        for (const auto& obj: objects) {
-            obj->debugDrawCollision(scroll);
+        auto& batch = PrimitiveBatch::debug();
+        for (const auto& obj: gather(view(), false)) {
+            if (obj->isDynamic()) {
+                obj->debugDrawCollision(scroll);
+            } else if (!batch.hasPersistent(debugKey(obj))) {
+                batch.beginPersistent(debugKey(obj));
+                obj->debugDrawCollision({0, 0});
+                batch.endPersistent();
+            }
         }
+        batch.flush(scroll);
     }
 
     str getName() {
@@ -1059,6 +1849,40 @@ public:
 
 
 
+inline void LevelLightSource::drawLighting(const dvec2 offset) {
+    if (!shadows || !Level) {
+        LightingPass::instance().addLight(collision.pos() - offset, radius, c, light_level);
+        return;
+    }
+
+    auto& cache = shadow_cache;
+    const dvec2 center = collision.pos();
+    if (!cache.valid || cache.center.x != center.x || cache.center.y != center.y ||
+        cache.radius != radius || cache.softness != shadow_softness) {
+        cache.samples = samplePoints();
+        cache.polygons.resize(cache.samples.size());
+        cache.occluded = false;
+        for (usize i = 0; i < cache.samples.size(); i++) {
+            if (Level->visibilityPolygon(cache.samples[i], abs(radius), cache.polygons[i])) cache.occluded = true;
+        }
+        cache.valid = true;
+        cache.center = center;
+        cache.radius = radius;
+        cache.softness = shadow_softness;
+    }
+
+    if (!cache.occluded) {
+        LightingPass::instance().addLight(center - offset, radius, c, light_level);
+        return;
+    }
+    //soft shadows are the light drawn from a few points around its center, each as bright as its share
+    const u8 level = cast(light_level / cache.samples.size(), u8);
+    for (usize i = 0; i < cache.samples.size(); i++) {
+        LightingPass::instance().addShadowedLight(cache.samples[i] - offset, radius, c, level, cache.polygons[i], offset);
+    }
+}
+
+
 inline bool DynamicLevelObject::move(const dvec2 amt, bool should_scroll) {
     //returns true if we moved at all
     rect future = collision;
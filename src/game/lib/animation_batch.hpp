@@ -0,0 +1,181 @@
+#ifndef ANIMATION_BATCH_HPP
+#define ANIMATION_BATCH_HPP
+
+#include <raymath.h>
+#include <rlgl.h>
+#include "utils.hpp"
+#include "instancing.hpp"
+#include "palette.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+//one looping animation drawn by the animation batch, same layout as the instance attributes in animated.vsh
+struct AnimatedInstance {
+    float x, y, w, h;
+    float frame_w, frame_h, frames, frame_duration;
+    float start, depth, stretch, unused;//stretch is 1 to scale one frame over the area instead of tiling it
+    float r, g, b, a;
+};
+
+/*
+ * draws looping animations without the cpu ever touching their frames, every instance carries its frame size,
+ * frame count, frame duration and when it started, and animated.vsh works out the frame from the batch's clock
+ * instances added one after another with the same texture make up a run and every run is a single instanced draw,
+ * runs get drawn in the order they were added so overlapping animations with different textures stay in order
+ * only animations that dont keep any state of their own (animation::isStateless) can go in here
+ */
+class AnimationBatch {
+    struct run {
+        Texture2D texture{};
+        usize first;
+        usize count;
+    };
+
+    Shader shader{};
+    i32 mvp_loc = -1;
+    i32 time_loc = -1;
+    i32 cutoff_loc = -1;
+    i32 palette_loc = -1;
+    i32 palette_row_loc = -1;
+    i32 indexed_loc = -1;
+    InstanceBuffer<AnimatedInstance> quads;
+
+    vector<AnimatedInstance> instances;//every run's instances one after another
+    vector<run> runs;
+    double clock = 0;
+    float depth = 0;
+    float alpha_cutoff = 0;
+
+    usize draw_calls = 0;
+    usize instances_drawn = 0;
+
+    AnimationBatch() {
+        shader = Allocator::allocateShader("resources/shaders/animated.vsh", "resources/shaders/animated.fsh");
+        mvp_loc = GetShaderLocation(shader, "mvp");
+        time_loc = GetShaderLocation(shader, "time");
+        cutoff_loc = GetShaderLocation(shader, "alphaCutoff");
+        palette_loc = GetShaderLocation(shader, "palette");
+        palette_row_loc = GetShaderLocation(shader, "paletteRow");
+        indexed_loc = GetShaderLocation(shader, "indexed");
+        quads.init({
+            {1, 4, offsetof(AnimatedInstance, x)},
+            {2, 4, offsetof(AnimatedInstance, frame_w)},
+            {3, 4, offsetof(AnimatedInstance, start)},
+            {4, 4, offsetof(AnimatedInstance, r)},
+        });
+    }
+
+    //makes room for count more instances at the end of the last run, or a new run if it has another texture
+    AnimatedInstance* append(const Texture2D& texture, const usize count, const AnimatedInstance& value) {
+        if (runs.empty() || runs.back().texture.id != texture.id) runs.push_back({texture, instances.size(), 0});
+        runs.back().count += count;
+        const usize first = instances.size();
+        instances.resize(first + count, value);
+        return instances.data() + first;
+    }
+
+public:
+    AnimationBatch(const AnimationBatch&) = delete;
+    AnimationBatch& operator =(const AnimationBatch&) = delete;
+
+    static AnimationBatch& instance() {
+        static AnimationBatch batch;
+        return batch;
+    }
+
+    //moves the clock every batched animation runs off of, called by the level so pausing stops them too
+    void advance(const seconds_t delta) {
+        clock += delta;
+    }
+
+    [[nodiscard]] double time() const {
+        return clock;
+    }
+
+    //the z everything added from now on gets drawn at, only matters while DepthSorter is active
+    void setDepth(const float z) {
+        depth = z;
+    }
+
+    //texels more see through than this get thrown away, so they dont write to the depth buffer
+    void setAlphaCutoff(const float cutoff) {
+        alpha_cutoff = cutoff;
+    }
+
+    //queues the animation to be drawn tiled across dest (like DrawAnimation), start is when it was on its first frame
+    void add(animation& anim, const rect& dest, const Color tint = WHITE, const double start = 0) {
+        append(anim.getTexture(), 1, {
+            cast(dest.x, float), cast(dest.y, float), cast(dest.w, float), cast(dest.h, float),
+            cast(anim.width(), float), cast(anim.height(), float), cast(anim.getMaxFrame(), float),
+            cast(anim.duration(), float),
+            cast(start, float), depth, 0, 0,
+            tint.r/255.0f, tint.g/255.0f, tint.b/255.0f, tint.a/255.0f
+        });
+    }
+
+    /*
+     * makes room for count instances of the animation and hands them back, for adding a lot of them at once (like
+     * particles), they start out covering nothing with the animation's frames, the current depth and a white tint
+     */
+    AnimatedInstance* reserve(animation& anim, const usize count) {
+        return append(anim.getTexture(), count, {
+            0, 0, 0, 0,
+            cast(anim.width(), float), cast(anim.height(), float), cast(anim.getMaxFrame(), float),
+            cast(anim.duration(), float),
+            0, depth, 0, 0,
+            1, 1, 1, 1
+        });
+    }
+
+    [[nodiscard]] bool empty() const {
+        return instances.empty();
+    }
+
+    /*
+     * draws everything queued up so far, one draw call per run, with whatever transform is active
+     * has to be called before anything that should end up on top of the queued animations gets drawn
+     */
+    void flush() {
+        if (instances.empty()) return;
+        //anything raylib has batched was drawn first, so it has to get to the gpu first too
+        rlDrawRenderBatchActive();
+
+        const Matrix mvp = MatrixMultiply(MatrixMultiply(rlGetMatrixTransform(), rlGetMatrixModelview()),
+                                          rlGetMatrixProjection());
+        const auto t = cast(clock, float);
+        rlEnableShader(shader.id);
+        rlSetUniformMatrix(mvp_loc, mvp);
+        rlSetUniform(time_loc, &t, RL_SHADER_UNIFORM_FLOAT, 1);
+        rlSetUniform(cutoff_loc, &alpha_cutoff, RL_SHADER_UNIFORM_FLOAT, 1);
+        const auto& palette = IndexedColor::instance();
+        palette.bindFor(palette_loc, palette_row_loc);
+        rlActiveTextureSlot(0);
+        for (const auto& r: runs) {
+            if (r.count == 0) continue;
+            //indexed sheets get their colors from the palette, see IndexedColor
+            const i32 indexed = palette.isIndexed(r.texture);
+            rlSetUniform(indexed_loc, &indexed, RL_SHADER_UNIFORM_INT, 1);
+            rlEnableTexture(r.texture.id);
+            quads.draw(instances.data() + r.first, r.count);
+            draw_calls++;
+            instances_drawn += r.count;
+        }
+        rlDisableTexture();
+        rlDisableShader();
+        instances.clear();
+        runs.clear();
+    }
+
+    //starts counting draw calls and instances over
+    void resetStats() {
+        draw_calls = instances_drawn = 0;
+    }
+
+    //how many draw calls and instances were drawn since resetStats()
+    [[nodiscard]] pair<usize, usize> stats() const {
+        return {draw_calls, instances_drawn};
+    }
+};
+
+#endif
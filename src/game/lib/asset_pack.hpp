@@ -0,0 +1,310 @@
+#ifndef ASSET_PACK_HPP
+#define ASSET_PACK_HPP
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <unordered_set>
+#include <raylib.h>
+#include "AustinUtils.hpp"
+#include "mapped_file.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+/*
+ * every texture and animation the game loads at startup, packed into one file (assets.pack, made by the AssetPacker
+ * target) so starting up is mapping one file instead of walking resources/ and data/animation/ and opening every file
+ * in them
+ * the pack goes:
+ *  - the header
+ *  - the payloads, every asset's bytes, 16 byte aligned
+ *  - the table of contents, one entry per asset sorted by the hash of its path, so finding one is a binary search
+ *  - the names, every asset's path, to tell apart paths with the same hash
+ * images can be stored as their png or already decoded, decoded ones go straight to the gpu out of the mapped file
+ * paths are relative to the game's working directory with forward slashes, like "resources/tiles/stone.png"
+ */
+
+enum class AssetType : u32 {
+    FILE,//anything else, the bytes of the file
+    IMAGE_PNG,//the png file, decoded when it's loaded
+    IMAGE_DECODED,//raw pixels, the entry has the size and raylib pixel format
+    ANIMATION,//an animation's json from data/animation
+};
+
+struct AssetPackHeader {
+    array<char, 4> magic{};
+    u32 version = 0;
+    u32 count = 0;
+    u32 unused = 0;
+    u64 toc_offset = 0;
+    u64 names_offset = 0;
+    u64 names_size = 0;
+};
+
+struct AssetEntry {
+    u64 hash = 0;
+    u64 offset = 0;
+    u64 size = 0;
+    u32 name_offset = 0;
+    u32 name_size = 0;
+    AssetType type = AssetType::FILE;
+    i32 width = 0;//only for decoded images
+    i32 height = 0;
+    i32 format = 0;
+};
+
+static_assert(sizeof(AssetPackHeader) == 40 && sizeof(AssetEntry) == 48);
+
+inline constexpr array<char, 4> asset_pack_magic = {'J', 'O', 'B', 'P'};
+inline constexpr u32 asset_pack_version = 1;
+
+//fnv-1a, only has to spread paths out, the names get compared anyway
+inline u64 hashAssetPath(const string_view path) {
+    u64 h = 0xCBF29CE484222325ull;
+    for (const char c: path) {
+        h ^= cast(cast(c, u8), u64);
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+//the path an asset is stored under, relative with forward slashes
+inline string normalizeAssetPath(const string_view path) {
+    filesystem::path p(path);
+    //only absolute paths have to ask the filesystem where they are
+    p = p.is_absolute() ? filesystem::relative(p) : p.lexically_normal();
+    string ret = p.generic_string();
+    for (auto& c: ret) {
+        if (c == '\\') c = '/';
+    }
+    return ret;
+}
+
+class AssetPack {
+    MappedFile file;
+    span<const AssetEntry> toc;
+    string_view names;
+    string path;
+
+    logger LAssetPack = logger("asset pack");
+
+    AssetPack() = default;
+
+    [[nodiscard]] bool inFile(const u64 offset, const u64 size) const {
+        return offset <= file.size() && size <= file.size() - offset;
+    }
+
+    //checks the whole pack once so nothing has to be checked when assets get loaded out of it
+    [[nodiscard]] bool valid() const {
+        if (file.size() < sizeof(AssetPackHeader)) return false;
+        const auto& header = *reinterpret_cast<const AssetPackHeader*>(file.data());
+        if (header.magic != asset_pack_magic || header.version != asset_pack_version) return false;
+        if (header.toc_offset % alignof(AssetEntry) != 0) return false;
+        if (!inFile(header.toc_offset, cast(header.count, u64) * sizeof(AssetEntry))) return false;
+        if (!inFile(header.names_offset, header.names_size)) return false;
+        const auto* entries = reinterpret_cast<const AssetEntry*>(file.data() + header.toc_offset);
+        for (u32 i = 0; i < header.count; i++) {
+            const AssetEntry& e = entries[i];
+            if (!inFile(e.offset, e.size) || e.name_offset > header.names_size ||
+                e.name_size > header.names_size - e.name_offset) return false;
+            if (i > 0 && entries[i - 1].hash > e.hash) return false;
+            if (e.type == AssetType::IMAGE_DECODED &&
+                cast(GetPixelDataSize(e.width, e.height, e.format), u64) != e.size) return false;
+        }
+        return true;
+    }
+
+public:
+    static constexpr const char* default_path = "assets.pack";
+
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator =(const AssetPack&) = delete;
+
+    static AssetPack& instance() {
+        static AssetPack pack;
+        return pack;
+    }
+
+    //maps the pack, everything that can be found in it gets loaded from it from now on
+    bool open(const string& pack_path) {
+        close();
+        if (!file.open(pack_path)) {
+            LAssetPack.info("No asset pack at ", pack_path, ", loading loose files");
+            return false;
+        }
+        if (!valid()) {
+            LAssetPack.warn("Asset pack ", pack_path, " is corrupt or from another version, loading loose files");
+            file.close();
+            return false;
+        }
+        const auto& header = *reinterpret_cast<const AssetPackHeader*>(file.data());
+        toc = {reinterpret_cast<const AssetEntry*>(file.data() + header.toc_offset), header.count};
+        names = {reinterpret_cast<const char*>(file.data() + header.names_offset), header.names_size};
+        path = pack_path;
+        LAssetPack.info("Mapped asset pack ", pack_path, " with ", toc.size(), " assets (", file.size() / 1024, " KB)");
+        return true;
+    }
+
+    void close() {
+        file.close();
+        toc = {};
+        names = {};
+    }
+
+    [[nodiscard]] bool isOpen() const {
+        return file.isOpen();
+    }
+
+    [[nodiscard]] const AssetEntry* find(const string_view asset_path) const {
+        if (!isOpen()) return nullptr;
+        const u64 h = hashAssetPath(asset_path);
+        auto it = ranges::lower_bound(toc, h, {}, &AssetEntry::hash);
+        for (; it != toc.end() && it->hash == h; ++it) {
+            if (name(*it) == asset_path) return &*it;
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] string_view name(const AssetEntry& e) const {
+        return names.substr(e.name_offset, e.name_size);
+    }
+
+    [[nodiscard]] span<const byte> data(const AssetEntry& e) const {
+        return {file.data() + e.offset, e.size};
+    }
+
+    [[nodiscard]] span<const AssetEntry> entries() const {
+        return toc;
+    }
+
+    [[nodiscard]] static bool isImage(const AssetEntry& e) {
+        return e.type == AssetType::IMAGE_PNG || e.type == AssetType::IMAGE_DECODED;
+    }
+
+    //decoded images go to the gpu straight out of the pack, nothing gets copied
+    [[nodiscard]] optional<Texture2D> loadTexture(const string_view asset_path) const {
+        const AssetEntry* e = find(asset_path);
+        if (!e || !isImage(*e)) return nullopt;
+        if (e->type == AssetType::IMAGE_DECODED) {
+            const Image view = {const_cast<byte*>(data(*e).data()), e->width, e->height, 1, e->format};
+            return LoadTextureFromImage(view);
+        }
+        Image image = LoadImageFromMemory(".png", reinterpret_cast<const unsigned char*>(data(*e).data()),
+                                          cast(e->size, i32));
+        const Texture2D ret = LoadTextureFromImage(image);
+        UnloadImage(image);
+        return ret;
+    }
+
+    //an image the caller owns (and has to unload), for when the pixels get changed before they're uploaded
+    [[nodiscard]] optional<Image> loadImage(const string_view asset_path) const {
+        const AssetEntry* e = find(asset_path);
+        if (!e || !isImage(*e)) return nullopt;
+        if (e->type == AssetType::IMAGE_PNG) {
+            return LoadImageFromMemory(".png", reinterpret_cast<const unsigned char*>(data(*e).data()),
+                                       cast(e->size, i32));
+        }
+        Image image = {RL_MALLOC(e->size), e->width, e->height, 1, e->format};
+        memcpy(image.data, data(*e).data(), e->size);
+        return image;
+    }
+
+    [[nodiscard]] optional<string_view> text(const string_view asset_path) const {
+        const AssetEntry* e = find(asset_path);
+        if (!e) return nullopt;
+        return string_view(reinterpret_cast<const char*>(data(*e).data()), e->size);
+    }
+};
+
+//writes a pack one asset at a time, so the packer never has to hold every asset at once
+class AssetPackWriter {
+    ofstream out;
+    string path;
+    vector<AssetEntry> toc;
+    vector<char> names;
+    unordered_set<string> added;
+
+    void pad(const u64 alignment) {
+        constexpr array<char, 16> zeros{};
+        const auto at = cast(out.tellp(), u64);
+        out.write(zeros.data(), cast((alignment - at % alignment) % alignment, streamsize));
+    }
+
+public:
+    explicit AssetPackWriter(const string& pack_path) : out(pack_path, ios::binary | ios::trunc), path(pack_path) {
+        if (!out.is_open()) throw Exception("Could not write asset pack ", pack_path);
+        //the real header is written once the table of contents is
+        const AssetPackHeader header;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    //width, height and format are only for decoded images
+    void add(const string_view asset_path, const AssetType type, const span<const byte> bytes,
+             const i32 width = 0, const i32 height = 0, const i32 format = 0) {
+        const string name = normalizeAssetPath(asset_path);
+        if (!added.insert(name).second) throw Exception("Asset ", name, " was packed twice");
+        pad(16);
+        AssetEntry e;
+        e.hash = hashAssetPath(name);
+        e.offset = cast(out.tellp(), u64);
+        e.size = bytes.size();
+        e.name_offset = cast(names.size(), u32);
+        e.name_size = cast(name.size(), u32);
+        e.type = type;
+        e.width = width;
+        e.height = height;
+        e.format = format;
+        out.write(reinterpret_cast<const char*>(bytes.data()), cast(bytes.size(), streamsize));
+        names.insert(names.end(), name.begin(), name.end());
+        toc.push_back(e);
+    }
+
+    //packs a file as it is on disk
+    void addFile(const string& file_path, const AssetType type) {
+        ifstream in(file_path, ios::binary);
+        if (!in.is_open()) throw Exception("Could not read ", file_path);
+        const string bytes((istreambuf_iterator(in)), istreambuf_iterator<char>());
+        add(file_path, type, as_bytes(span(bytes)));
+    }
+
+    //decode stores the pixels instead of the png, bigger but nothing has to be decoded when the game starts
+    void addImage(const string& file_path, const bool decode) {
+        if (!decode) {
+            addFile(file_path, AssetType::IMAGE_PNG);
+            return;
+        }
+        Image image = LoadImage(file_path.data());
+        if (!image.data) throw Exception("Could not load image ", file_path);
+        const auto size = cast(GetPixelDataSize(image.width, image.height, image.format), usize);
+        add(file_path, AssetType::IMAGE_DECODED, {static_cast<const byte*>(image.data), size},
+            image.width, image.height, image.format);
+        UnloadImage(image);
+    }
+
+    [[nodiscard]] usize count() const {
+        return toc.size();
+    }
+
+    //writes the table of contents and the header, the pack can be opened once this is done
+    void finish() {
+        ranges::sort(toc, {}, &AssetEntry::hash);
+        pad(alignof(AssetEntry));
+        AssetPackHeader header;
+        header.magic = asset_pack_magic;
+        header.version = asset_pack_version;
+        header.count = cast(toc.size(), u32);
+        header.toc_offset = cast(out.tellp(), u64);
+        out.write(reinterpret_cast<const char*>(toc.data()), cast(toc.size() * sizeof(AssetEntry), streamsize));
+        header.names_offset = cast(out.tellp(), u64);
+        header.names_size = names.size();
+        out.write(names.data(), cast(names.size(), streamsize));
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.close();
+        if (!out) throw Exception("Could not write asset pack ", path);
+    }
+};
+
+#endif
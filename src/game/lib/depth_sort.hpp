@@ -0,0 +1,138 @@
+#ifndef DEPTH_SORT_HPP
+#define DEPTH_SORT_HPP
+
+#include <rlgl.h>
+#include "utils.hpp"
+#include "animation_batch.hpp"
+#include "palette.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+/*
+ * lets the depth buffer work out which object goes in front instead of sorting them on the cpu
+ * every object gets drawn at a z made from its depth() (the bottom of its collision), so objects further down the
+ * screen end up in front no matter what order they're drawn in, and the level can order them by texture so raylib
+ * batches as much as it can
+ * pixels that are mostly see through get discarded (alpha_test.fsh) so the empty parts of a sprite dont hide what's
+ * behind them, anything that's actually translucent still has to be drawn afterward in depth order
+ *
+ * the projection gets swapped for one with a much deeper z range so one pixel of depth is much bigger than the tiny
+ * z step raylib adds to every draw, objects at the same depth end up with the same z and the last one drawn wins
+ */
+class DepthSorter {
+    Shader alpha_test{};
+    i32 cutoff_loc = -1;
+    Matrix previous_projection{};
+    double origin = 0;//the depth that ends up at z 0
+    bool active = false;
+
+    DepthSorter() {
+        alpha_test = Allocator::allocateShader(nullptr, "resources/shaders/alpha_test.fsh");
+        cutoff_loc = GetShaderLocation(alpha_test, "alphaCutoff");
+    }
+
+public:
+    static constexpr float range = 65536;//how far the z goes either way
+    static constexpr float alpha_cutoff = 0.5f;
+
+    DepthSorter(const DepthSorter&) = delete;
+    DepthSorter& operator =(const DepthSorter&) = delete;
+
+    static DepthSorter& instance() {
+        static DepthSorter d;
+        return d;
+    }
+
+    /*
+     * starts drawing opaque (or cut out) objects, has to be inside of a texture mode that has a depth buffer
+     * origin is the depth that gets put in the middle of the z range, usually the top of the view
+     */
+    void begin(const double origin_depth) {
+        rlDrawRenderBatchActive();
+        origin = origin_depth;
+        active = true;
+
+        //same projection, the z part is just a lot deeper (ortho with near -range and far range)
+        previous_projection = rlGetMatrixProjection();
+        Matrix projection = previous_projection;
+        projection.m10 = -1.0f / range;
+        projection.m14 = 0;
+        rlSetMatrixProjection(projection);
+
+        rlEnableDepthTest();
+        rlEnableDepthMask();
+        IndexedColor::instance().setBaseShader(alpha_test);
+        BeginShaderMode(alpha_test);
+        SetShaderValue(alpha_test, cutoff_loc, &alpha_cutoff, SHADER_UNIFORM_FLOAT);
+        AnimationBatch::instance().setAlphaCutoff(alpha_cutoff);
+        IndexedColor::instance().setAlphaCutoff(alpha_cutoff);
+    }
+
+    //the z an object with this depth gets drawn at, further down is closer to the camera
+    [[nodiscard]] float z(const double depth) const {
+        if (std::isinf(depth)) return depth < 0 ? -(range - 1) : range - 1;
+        return cast(std::clamp(depth - origin, cast(-(range - 1), double), cast(range - 1, double)), float);
+    }
+
+    //everything drawn until pop() ends up at the object's depth
+    void push(const double depth) const {
+        rlPushMatrix();
+        rlTranslatef(0, 0, z(depth));
+    }
+
+    void pop() const {
+        rlPopMatrix();
+    }
+
+    /*
+     * for the floors and what goes right on top of them (until endGround()), everything else is in front of them
+     * anyway, so they dont write any depth and nothing gets cut out, they're just drawn in order
+     */
+    void beginGround() const {
+        rlDrawRenderBatchActive();
+        IndexedColor::instance().setBaseShader(nullopt);
+        EndShaderMode();
+        AnimationBatch::instance().setAlphaCutoff(0);
+        IndexedColor::instance().setAlphaCutoff(0);
+        rlDisableDepthMask();
+    }
+
+    void endGround() const {
+        rlDrawRenderBatchActive();
+        rlEnableDepthMask();
+        IndexedColor::instance().setBaseShader(alpha_test);
+        BeginShaderMode(alpha_test);
+        AnimationBatch::instance().setAlphaCutoff(alpha_cutoff);
+        IndexedColor::instance().setAlphaCutoff(alpha_cutoff);
+    }
+
+    /*
+     * switches to drawing translucent objects, they still get hidden by anything opaque in front of them but dont
+     * hide anything themselves, so they have to be drawn back to front
+     */
+    void beginTranslucent() const {
+        rlDrawRenderBatchActive();
+        IndexedColor::instance().setBaseShader(nullopt);
+        EndShaderMode();
+        AnimationBatch::instance().setAlphaCutoff(0);
+        IndexedColor::instance().setAlphaCutoff(0);
+        rlDisableDepthMask();
+    }
+
+    void end() {
+        if (!active) return;
+        rlDrawRenderBatchActive();
+        IndexedColor::instance().setBaseShader(nullopt);
+        EndShaderMode();
+        AnimationBatch::instance().setAlphaCutoff(0);
+        AnimationBatch::instance().setDepth(0);
+        IndexedColor::instance().setAlphaCutoff(0);
+        rlEnableDepthMask();
+        rlDisableDepthTest();
+        rlSetMatrixProjection(previous_projection);
+        active = false;
+    }
+};
+
+#endif
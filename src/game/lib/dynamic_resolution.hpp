@@ -0,0 +1,151 @@
+#ifndef DYNAMIC_RESOLUTION_HPP
+#define DYNAMIC_RESOLUTION_HPP
+
+#include <numeric>
+#include <rlgl.h>
+#include "globals.hpp"
+#include "utils.hpp"
+#include "lighting.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+/*
+ * drops the resolution the scene (rbuf) and the light buffer are drawn at when frames take too long, and brings it
+ * back up once there's room again
+ * the resolution is always base_resolution divided by a whole number that divides it evenly, so every texel of
+ * rbuf covers the same amount of art pixels and the pixel art doesnt get uneven, the final blit scales it back up
+ * the world is still laid out in base_resolution units, the scene is just drawn scaled down into the smaller rbuf
+ */
+class DynamicResolution {
+    bool enabled = false;
+    double target_fps = 60;
+    vector<i32> factors = {1};//every factor that's allowed, smallest first
+    usize current = 0;//index into factors
+
+    double smoothed_frame_ms = 0;
+    double smoothed_cpu_ms = 0;
+    usize over_frames = 0;
+    usize under_frames = 0;
+    usize cooldown = 0;
+    high_resolution_clock::time_point frame_start;
+
+    logger LRes = logger("dynamic-resolution");
+
+    DynamicResolution() = default;
+
+    void apply() {
+        const i32 f = factor();
+        Allocator::free(rbuf);
+        rbuf = Allocator::allocateRenderTexture(base_resolution.x / f, base_resolution.y / f);
+        LightingPass::instance().setScale(1.0f / f);
+        //let the new resolution settle before judging it
+        cooldown = 30;
+        over_frames = under_frames = 0;
+        LRes.info("Drawing at 1/", f, " resolution (", base_resolution.x / f, "x", base_resolution.y / f, ")");
+    }
+
+public:
+    static constexpr usize react_frames = 20;//frames over budget in a row before the resolution drops
+    static constexpr usize recover_frames = 120;//frames well under budget in a row before it goes back up
+    static constexpr double over_budget = 1.1;
+    static constexpr double under_budget = 0.65;
+
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator =(const DynamicResolution&) = delete;
+
+    static DynamicResolution& instance() {
+        static DynamicResolution d;
+        return d;
+    }
+
+    //the settings.json entry when it doesnt have one
+    static json defaultConfig() {
+        return {{"enabled", true}, {"target_fps", 60}, {"max_factor", 4}};
+    }
+
+    static bool validateConfig(const json& config) {
+        return validateJsonData(config, "enabled", json::value_t::boolean) &&
+               validateJsonData(config, "target_fps", JSON_NUMBERS) &&
+               validateJsonData(config, "max_factor", JSON_INTEGERS);
+    }
+
+    //has to be called after rbuf is made
+    void configure(const json& config) {
+        enabled = config["enabled"].get<bool>();
+        target_fps = std::max(1.0, config["target_fps"].get<double>());
+        const i32 max_factor = std::max(1, config["max_factor"].get<i32>());
+
+        //only factors that divide both sides of base_resolution keep every texel the same size
+        factors.clear();
+        const i32 g = std::gcd(base_resolution.x, base_resolution.y);
+        for (i32 f = 1; f <= max_factor; f++) {
+            if (g % f == 0) factors.push_back(f);
+        }
+        if (current != 0) {
+            current = 0;
+            apply();
+        }
+    }
+
+    //call once at the start of every frame with how long the last one took
+    void beginFrame(const double delta) {
+        frame_start = high_resolution_clock::now();
+        if (delta <= 0) return;
+        smoothed_frame_ms = smoothed_frame_ms * 0.9 + delta * 1000 * 0.1;
+        if (!enabled) return;
+        if (cooldown > 0) {
+            cooldown--;
+            return;
+        }
+
+        const double budget = 1000 / target_fps;
+        over_frames = smoothed_frame_ms > budget * over_budget ? over_frames + 1 : 0;
+        under_frames = smoothed_frame_ms < budget * under_budget ? under_frames + 1 : 0;
+
+        if (over_frames >= react_frames && current + 1 < factors.size()) {
+            current++;
+            apply();
+        } else if (under_frames >= recover_frames && current > 0) {
+            current--;
+            apply();
+        }
+    }
+
+    //call once everything for the frame is submitted (right before EndDrawing), so the cpu side can be told apart
+    void endCpu() {
+        const double ms = cast(duration_cast<nanoseconds>(high_resolution_clock::now() - frame_start).count(), double) / 1e6;
+        smoothed_cpu_ms = smoothed_cpu_ms * 0.9 + ms * 0.1;
+    }
+
+    //BeginTextureMode(rbuf), with everything scaled down to whatever size rbuf is right now
+    void beginScene() const {
+        BeginTextureMode(rbuf);
+        rlPushMatrix();
+        rlScalef(scale(), scale(), 1);
+    }
+
+    void endScene() const {
+        rlPopMatrix();
+        EndTextureMode();
+    }
+
+    [[nodiscard]] i32 factor() const {
+        return factors[current];
+    }
+
+    [[nodiscard]] float scale() const {
+        return 1.0f / cast(factor(), float);
+    }
+
+    //how long frames are taking and how much of that is the cpu, both smoothed
+    [[nodiscard]] double frameMs() const {
+        return smoothed_frame_ms;
+    }
+
+    [[nodiscard]] double cpuMs() const {
+        return smoothed_cpu_ms;
+    }
+};
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef FILE_SAVER_HPP
+#define FILE_SAVER_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "AustinUtils.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+//how one file queued with FileSaver::save went, error is empty if it was written
+struct SaveResult {
+    string path;
+    string error;
+};
+
+/*
+ * writes files on its own thread, so saving something big never holds up a frame
+ * whoever queues a file takes a snapshot of what goes in it first (the write function owns it), the thing it came from
+ * can keep changing while it's written
+ * every file gets written next to where it goes and then renamed over the old one, so nothing (a crash, the game, the
+ * file watcher) ever sees half of a file
+ * files are written one at a time in the order they were queued
+ */
+class FileSaver {
+    using writer_t = function<void(const string&)>;
+
+    struct job {
+        string path;
+        writer_t write;
+    };
+
+    mutex m;
+    condition_variable wake;
+    condition_variable idle;
+    deque<job> jobs;
+    vector<SaveResult> results;
+    bool writing = false;
+    bool stopping = false;
+
+    jthread thread;//last, so it's joined before anything it uses is destroyed
+
+    FileSaver() = default;
+
+    void workerLoop() {
+        while (true) {
+            unique_lock lock(m);
+            //whatever was queued still gets written when the program closes
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) return;
+            job j = std::move(jobs.front());
+            jobs.pop_front();
+            writing = true;
+            lock.unlock();
+
+            SaveResult r{j.path, {}};
+            try {
+                writeAtomically(j.path, j.write);
+            } catch (const exception& e) {
+                r.error = e.what();
+            }
+
+            lock.lock();
+            results.push_back(std::move(r));
+            writing = false;
+            if (jobs.empty()) idle.notify_all();
+        }
+    }
+
+public:
+    FileSaver(const FileSaver&) = delete;
+    FileSaver& operator =(const FileSaver&) = delete;
+
+    ~FileSaver() {
+        {
+            lock_guard lock(m);
+            stopping = true;
+        }
+        wake.notify_all();
+    }
+
+    static FileSaver& instance() {
+        static FileSaver saver;
+        return saver;
+    }
+
+    //write gets a path next to the file and has to write all of it there, the file is only replaced once it returns
+    static void writeAtomically(const string& path, const writer_t& write) {
+        const string temp = path + ".tmp";
+        try {
+            write(temp);
+            error_code ec;
+            filesystem::rename(temp, path, ec);
+            if (ec) throw Exception("Could not replace ", path, ": ", ec.message());
+        } catch (...) {
+            error_code ec;
+            filesystem::remove(temp, ec);
+            throw;
+        }
+    }
+
+    //write is called from the saver's thread, so it cant touch anything the main thread might be changing
+    void save(string path, writer_t write) {
+        {
+            lock_guard lock(m);
+            if (!thread.joinable()) thread = jthread([this] { workerLoop(); });
+            jobs.push_back({std::move(path), std::move(write)});
+        }
+        wake.notify_one();
+    }
+
+    //true while anything is queued or being written
+    [[nodiscard]] bool saving() {
+        lock_guard lock(m);
+        return writing || !jobs.empty();
+    }
+
+    //how every file written since the last call went
+    vector<SaveResult> finished() {
+        lock_guard lock(m);
+        return exchange(results, {});
+    }
+
+    //waits for everything queued to be written
+    void wait() {
+        unique_lock lock(m);
+        idle.wait(lock, [this] { return !writing && jobs.empty(); });
+    }
+};
+
+#endif
@@ -0,0 +1,227 @@
+#include "file_watcher.hpp"
+#include <algorithm>
+#include <array>
+#include <filesystem>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+void FileWatcher::changedFile(std::string path) {
+    std::ranges::replace(path, '\\', '/');
+    {
+        std::lock_guard lock(m);
+        changed[std::move(path)] = std::chrono::steady_clock::now();
+    }
+    has_changes.store(true, std::memory_order_relaxed);
+}
+
+std::vector<std::string> FileWatcher::take(const double settle_ms) {
+    std::vector<std::string> ret;
+    if (!pending()) return ret;
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard lock(m);
+    for (auto it = changed.begin(); it != changed.end();) {
+        if (std::chrono::duration<double, std::milli>(now - it->second).count() < settle_ms) {
+            ++it;
+            continue;
+        }
+        ret.push_back(it->first);
+        it = changed.erase(it);
+    }
+    has_changes.store(!changed.empty(), std::memory_order_relaxed);
+    return ret;
+}
+
+FileWatcher::~FileWatcher() {
+    stop();
+}
+
+#ifdef _WIN32
+
+struct FileWatcher::platform {
+    struct directory {
+        std::string path;
+        HANDLE handle = INVALID_HANDLE_VALUE;
+        OVERLAPPED overlapped{};
+        alignas(DWORD) std::array<std::byte, 16384> buffer{};
+    };
+
+    std::vector<std::unique_ptr<directory>> directories;
+    HANDLE wake = nullptr;//set to stop the thread
+};
+
+//asks for the next batch of changes, the directory's event gets set once there are some
+static bool listen(HANDLE handle, OVERLAPPED& overlapped, std::array<std::byte, 16384>& buffer) {
+    return ReadDirectoryChangesW(handle, buffer.data(), static_cast<DWORD>(buffer.size()), TRUE,
+                                 FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME, nullptr, &overlapped,
+                                 nullptr);
+}
+
+FileWatcher::FileWatcher() : os(std::make_unique<platform>()) {}
+
+//a watch on a directory already covers everything in it
+void FileWatcher::watchDirectory(const std::string& directory) {
+    auto d = std::make_unique<platform::directory>();
+    d->path = directory;
+    d->handle = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                            FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (d->handle == INVALID_HANDLE_VALUE) return;
+    d->overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    if (!d->overlapped.hEvent || !listen(d->handle, d->overlapped, d->buffer)) {
+        if (d->overlapped.hEvent) CloseHandle(d->overlapped.hEvent);
+        CloseHandle(d->handle);
+        return;
+    }
+    os->directories.push_back(std::move(d));
+}
+
+bool FileWatcher::start(const std::vector<std::string>& directories) {
+    stop();
+    for (const auto& d: directories) watchDirectory(d);
+    if (os->directories.empty()) return false;
+    os->wake = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    thread = std::thread([this] { run(); });
+    return true;
+}
+
+void FileWatcher::run() {
+    std::vector<HANDLE> events;
+    for (const auto& d: os->directories) events.push_back(d->overlapped.hEvent);
+    events.push_back(os->wake);
+    while (true) {
+        const DWORD r = WaitForMultipleObjects(static_cast<DWORD>(events.size()), events.data(), FALSE, INFINITE);
+        if (r == WAIT_FAILED || r >= WAIT_OBJECT_0 + os->directories.size()) return;
+        auto& d = *os->directories[r - WAIT_OBJECT_0];
+        DWORD bytes = 0;
+        //0 bytes means there were too many changes for the buffer, they're lost so just keep going
+        if (GetOverlappedResult(d.handle, &d.overlapped, &bytes, FALSE) && bytes > 0) {
+            auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(d.buffer.data());
+            while (true) {
+                if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED ||
+                    info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+                    const int length = static_cast<int>(info->FileNameLength / sizeof(WCHAR));
+                    const int size = WideCharToMultiByte(CP_UTF8, 0, info->FileName, length, nullptr, 0, nullptr,
+                                                         nullptr);
+                    std::string name(static_cast<std::size_t>(size), '\0');
+                    WideCharToMultiByte(CP_UTF8, 0, info->FileName, length, name.data(), size, nullptr, nullptr);
+                    changedFile(d.path + "/" + name);
+                }
+                if (info->NextEntryOffset == 0) break;
+                info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(
+                    reinterpret_cast<const std::byte*>(info) + info->NextEntryOffset);
+            }
+        }
+        ResetEvent(d.overlapped.hEvent);
+        if (!listen(d.handle, d.overlapped, d.buffer)) return;
+    }
+}
+
+void FileWatcher::stop() {
+    if (thread.joinable()) {
+        SetEvent(os->wake);
+        thread.join();
+    }
+    for (const auto& d: os->directories) {
+        //the read has to be done with the buffer before it goes away
+        DWORD bytes = 0;
+        CancelIoEx(d->handle, &d->overlapped);
+        GetOverlappedResult(d->handle, &d->overlapped, &bytes, TRUE);
+        CloseHandle(d->overlapped.hEvent);
+        CloseHandle(d->handle);
+    }
+    os->directories.clear();
+    if (os->wake) CloseHandle(os->wake);
+    os->wake = nullptr;
+}
+
+#else
+
+struct FileWatcher::platform {
+    int inotify = -1;
+    int wake = -1;//written to stop the thread
+    std::unordered_map<int, std::string> directories;//watch descriptor -> the directory it watches
+};
+
+FileWatcher::FileWatcher() : os(std::make_unique<platform>()) {}
+
+//inotify only watches the directory itself, so every directory in it needs its own watch
+void FileWatcher::watchDirectory(const std::string& directory) {
+    constexpr uint32_t events = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+    const int wd = inotify_add_watch(os->inotify, directory.c_str(), events | IN_ONLYDIR);
+    if (wd < 0) return;
+    os->directories[wd] = directory;
+    std::error_code ec;
+    for (const auto& entry: std::filesystem::directory_iterator(directory, ec)) {
+        if (entry.is_directory(ec)) watchDirectory(entry.path().generic_string());
+    }
+}
+
+bool FileWatcher::start(const std::vector<std::string>& directories) {
+    stop();
+    os->inotify = inotify_init1(IN_CLOEXEC);
+    if (os->inotify < 0) return false;
+    for (const auto& d: directories) watchDirectory(d);
+    os->wake = eventfd(0, EFD_CLOEXEC);
+    if (os->directories.empty() || os->wake < 0) {
+        stop();
+        return false;
+    }
+    thread = std::thread([this] { run(); });
+    return true;
+}
+
+void FileWatcher::run() {
+    std::array<pollfd, 2> fds = {pollfd{os->inotify, POLLIN, 0}, pollfd{os->wake, POLLIN, 0}};
+    alignas(inotify_event) std::array<char, 4096> buffer{};
+    while (true) {
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        if (fds[1].revents) return;
+        const ssize_t n = read(os->inotify, buffer.data(), buffer.size());
+        if (n <= 0) continue;
+        for (const char* p = buffer.data(); p < buffer.data() + n;) {
+            const auto* e = reinterpret_cast<const inotify_event*>(p);
+            p += sizeof(inotify_event) + e->len;
+            if (e->mask & IN_IGNORED) {
+                os->directories.erase(e->wd);
+                continue;
+            }
+            const auto d = os->directories.find(e->wd);
+            if (d == os->directories.end() || e->len == 0) continue;
+            std::string path = d->second + "/" + e->name;
+            if (e->mask & IN_ISDIR) {
+                //files that get put in it before it's watched are missed, they show up the next time they change
+                watchDirectory(path);
+                continue;
+            }
+            //a new file gets IN_CLOSE_WRITE once it's written, IN_CREATE alone is an empty file
+            if (e->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) changedFile(std::move(path));
+        }
+    }
+}
+
+void FileWatcher::stop() {
+    if (thread.joinable()) {
+        constexpr uint64_t one = 1;
+        [[maybe_unused]] const ssize_t written = write(os->wake, &one, sizeof(one));
+        thread.join();
+    }
+    if (os->inotify >= 0) close(os->inotify);
+    if (os->wake >= 0) close(os->wake);
+    os->inotify = os->wake = -1;
+    os->directories.clear();
+}
+
+#endif
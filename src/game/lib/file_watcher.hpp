@@ -0,0 +1,60 @@
+#ifndef FILE_WATCHER_HPP
+#define FILE_WATCHER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * watches directories (and everything in them) for files that get written, on its own thread that sleeps in the os
+ * until something changes, so watching costs nothing while nothing changes
+ * inotify on linux and ReadDirectoryChangesW on windows, the platform code lives in file_watcher.cpp since windows.h
+ * and raylib cant be included in the same file
+ * paths come out as the directory they were found in (the way it was given) plus the file's path inside it, with
+ * forward slashes, like "resources/tiles/stone.png"
+ */
+class FileWatcher {
+    struct platform;//the os handles, see file_watcher.cpp
+    std::unique_ptr<platform> os;
+    std::thread thread;
+
+    std::mutex m;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> changed;//when every file last changed
+    std::atomic<bool> has_changes = false;
+
+    void changedFile(std::string path);
+    void watchDirectory(const std::string& directory);
+    void run();
+
+public:
+    FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator =(const FileWatcher&) = delete;
+
+    ~FileWatcher();
+
+    //starts watching the directories, returns false if none of them could be watched
+    bool start(const std::vector<std::string>& directories);
+
+    void stop();
+
+    [[nodiscard]] bool watching() const {
+        return thread.joinable();
+    }
+
+    //true while there are changes that havent been taken, checking it is one atomic load
+    [[nodiscard]] bool pending() const {
+        return has_changes.load(std::memory_order_relaxed);
+    }
+
+    //the files that changed and then didnt change again for settle_ms, programs tend to write a file in a few steps
+    std::vector<std::string> take(double settle_ms);
+};
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef FRAME_PACER_HPP
+#define FRAME_PACER_HPP
+
+#include <thread>
+#include "utils.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+//how evenly the last frames were paced, everything is in ms and smoothed
+struct FramePacingStats {
+    double frame_ms = 0;//real time from one frame to the next
+    double jitter_ms = 0;//standard deviation of frame_ms
+    double worst_ms = 0;//the furthest a frame landed from its deadline over the last second or so
+    double busy_ms = 0;//how much of the frame was actually spent working
+    double sleep_ms = 0;
+    double spin_ms = 0;
+};
+
+/*
+ * holds the main loop to a target frame rate and measures the real time between frames
+ * waiting sleeps most of the way to the next deadline and spins for the last bit, sleeping is cheap but the os can
+ * wake the thread up late (up to a whole timer tick on some systems), spinning is exact but burns the core
+ * the spin margin follows how late sleeps have actually been waking up, so it's only as big as it has to be
+ * deadlines are a fixed step apart instead of "target after the last frame ended", so a late frame doesnt push every
+ * frame after it back, once a frame is more than a whole step late the schedule just starts over from it
+ */
+class FramePacer {
+    using clock = high_resolution_clock;
+
+    bool enabled = true;
+    double game_fps = 120;
+    double editor_fps = 60;
+    double background_fps = 15;//when the window isnt focused
+    double min_spin_ms = 0.5;
+    bool editor = false;
+
+    clock::time_point last_frame{};
+    clock::time_point deadline{};
+    clock::duration busy{};
+    double oversleep_ms = 1;//how late sleeps have been waking up, decays back down slowly
+
+    FramePacingStats stats;
+    double frame_ms_mean = 0;
+    double frame_ms_var = 0;
+    double worst_window = 0;
+    usize window_frames = 0;
+
+    FramePacer() = default;
+
+    static double ms(const clock::duration d) {
+        return cast(duration_cast<nanoseconds>(d).count(), double) / 1e6;
+    }
+
+    [[nodiscard]] clock::duration period() const {
+        return duration_cast<clock::duration>(duration<double>(1.0 / targetFps()));
+    }
+
+public:
+    static constexpr usize worst_window_frames = 60;
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator =(const FramePacer&) = delete;
+
+    static FramePacer& instance() {
+        static FramePacer p;
+        return p;
+    }
+
+    //the settings.json entry when it doesnt have one, a target of 0 doesnt cap the frame rate
+    static json defaultConfig() {
+        return {{"enabled", true}, {"target_fps", 120}, {"editor_fps", 60}, {"background_fps", 15}, {"spin_ms", 0.5}};
+    }
+
+    static bool validateConfig(const json& config) {
+        return validateJsonData(config, "enabled", json::value_t::boolean) &&
+               validateJsonData(config, "target_fps", JSON_NUMBERS) &&
+               validateJsonData(config, "editor_fps", JSON_NUMBERS) &&
+               validateJsonData(config, "background_fps", JSON_NUMBERS) &&
+               validateJsonData(config, "spin_ms", JSON_NUMBERS);
+    }
+
+    //in_editor picks editor_fps instead of target_fps
+    void configure(const json& config, const bool in_editor = false) {
+        enabled = config["enabled"].get<bool>();
+        game_fps = std::max(0.0, config["target_fps"].get<double>());
+        editor_fps = std::max(0.0, config["editor_fps"].get<double>());
+        background_fps = std::max(0.0, config["background_fps"].get<double>());
+        min_spin_ms = std::max(0.0, config["spin_ms"].get<double>());
+        editor = in_editor;
+        deadline = clock::now();
+    }
+
+    //the frame rate frames are being held to right now, 0 means as fast as possible
+    [[nodiscard]] double targetFps() const {
+        if (!enabled) return 0;
+        const double fps = editor ? editor_fps : game_fps;
+        if (background_fps > 0 && (!IsWindowFocused() || IsWindowMinimized())) {
+            return fps > 0 ? std::min(fps, background_fps) : background_fps;
+        }
+        return fps;
+    }
+
+    void setTargetFps(const double fps) {
+        (editor ? editor_fps : game_fps) = std::max(0.0, fps);
+    }
+
+    /*
+     * call once at the very start of every frame, gives back the real time since the last frame started in seconds
+     * (0 on the first frame)
+     */
+    double beginFrame() {
+        const clock::time_point now = clock::now();
+        if (last_frame == clock::time_point{}) {
+            last_frame = deadline = now;
+            return 0;
+        }
+        const double frame = ms(now - last_frame);
+        last_frame = now;
+
+        stats.frame_ms = stats.frame_ms * 0.9 + frame * 0.1;
+        //smoothed variance, the jitter is how far frames wander from the smoothed frame time
+        const double diff = frame - frame_ms_mean;
+        frame_ms_mean += diff * 0.1;
+        frame_ms_var = frame_ms_var * 0.9 + diff * diff * 0.1;
+        stats.jitter_ms = std::sqrt(frame_ms_var);
+        return frame / 1000;
+    }
+
+    //the next beginFrame() acts like the first one, for when the loop stopped on purpose (like waiting for input)
+    void skipFrame() {
+        last_frame = {};
+    }
+
+    //call once at the very end of every frame (after EndDrawing), waits until it's time for the next one
+    void wait() {
+        const clock::time_point work_end = clock::now();
+        busy = work_end - last_frame;
+        stats.busy_ms = stats.busy_ms * 0.9 + ms(busy) * 0.1;
+
+        const double fps = targetFps();
+        if (fps <= 0) {
+            stats.sleep_ms = stats.spin_ms = 0;
+            deadline = work_end;
+            return;
+        }
+
+        deadline += period();
+        //more than a whole frame behind, catching up would just mean a burst of frames with no waiting
+        if (work_end - deadline > period()) deadline = work_end;
+
+        //sleep a millisecond at a time until sleeping again could wake up too late
+        const double margin = std::max(min_spin_ms, oversleep_ms);
+        clock::time_point now = work_end;
+        while (ms(deadline - now) > margin) {
+            const clock::time_point before = now;
+            this_thread::sleep_for(1ms);
+            now = clock::now();
+            const double late = ms(now - before) - 1;
+            oversleep_ms = late > oversleep_ms ? late : oversleep_ms * 0.99 + std::max(late, 0.0) * 0.01;
+        }
+        const clock::time_point spin_start = now;
+        while (now < deadline) {
+            this_thread::yield();
+            now = clock::now();
+        }
+
+        stats.sleep_ms = stats.sleep_ms * 0.9 + ms(spin_start - work_end) * 0.1;
+        stats.spin_ms = stats.spin_ms * 0.9 + ms(now - spin_start) * 0.1;
+
+        worst_window = std::max(worst_window, std::abs(ms(now - deadline)));
+        if (++window_frames >= worst_window_frames) {
+            stats.worst_ms = worst_window;
+            worst_window = 0;
+            window_frames = 0;
+        }
+    }
+
+    //how long the last frame spent working (not waiting), in seconds, this is what the frame rate could be without a cap
+    [[nodiscard]] double busyTime() const {
+        return ms(busy) / 1000;
+    }
+
+    [[nodiscard]] const FramePacingStats& lastStats() const {
+        return stats;
+    }
+};
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef FRAME_PIPELINE_HPP
+#define FRAME_PIPELINE_HPP
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "utils.hpp"
+#include "lighting.hpp"
+#include "text.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+//a line of ui text, drawn straight onto the screen, the text lives in the command so recording it doesnt allocate
+struct TextCommand {
+    FixedText<192> text;
+    i32 x = 0;
+    i32 y = 0;
+    i32 size = 20;
+    Color color = WHITE;
+    TextFont font = TextFont::DEFAULT;
+};
+
+//everything a frame draws that can be worked out without the gpu, once it's recorded nothing it points to can change
+struct RenderCommandList {
+    LightList lighting;
+    vector<TextCommand> ui;
+
+    void drawUI() const {
+        for (const auto& t: ui) {
+            TextCache::instance().draw(t.text.view(), cast(t.x, float), cast(t.y, float), t.size, t.color, t.font);
+        }
+    }
+};
+
+//how long the last frames spent updating and rendering, and how much of that happened at the same time
+struct PipelineStats {
+    double update_ms = 0;
+    double render_ms = 0;
+    double overlap_ms = 0;
+};
+
+/*
+ * runs the game's update for the next frame on its own thread while the current frame is being rendered
+ * raylib has to keep the window, the gl context and input polling on the main thread, so the main thread is the one
+ * that renders and the update moves off of it instead
+ * a frame goes:
+ *  - sync(): wait for the update, its command list becomes the one being rendered
+ *  - draw the scene into rbuf and record the ui (the level isnt changing, the update is done)
+ *  - launch(): the next update starts, it records its lights into the other command list when it's done
+ *  - render the lights, post processing and ui from the list sync() gave back, then EndDrawing
+ * the two command lists get swapped every frame, so the update never writes to the list being rendered
+ * with the pipeline off the update just runs inside of launch(), so the frame is the same but nothing overlaps
+ */
+class FramePipeline {
+    using job_t = function<void(double, RenderCommandList&)>;
+
+    array<RenderCommandList, 2> lists;
+    usize recording = 0;//the list the update is writing to
+    job_t job;
+    bool enabled = true;
+
+    mutex m;
+    condition_variable wake;
+    condition_variable done;
+    bool has_job = false;
+    bool working = false;
+    bool stopping = false;
+    double job_delta = 0;
+    exception_ptr failure;
+
+    high_resolution_clock::time_point update_start, update_end, render_start, render_end;
+    PipelineStats stats;
+
+    jthread worker;//last, so it's joined before anything it uses is destroyed
+
+    FramePipeline() = default;
+
+    static double ms(const high_resolution_clock::duration d) {
+        return cast(duration_cast<nanoseconds>(d).count(), double) / 1e6;
+    }
+
+    void run() {
+        update_start = high_resolution_clock::now();
+        try {
+            job(job_delta, lists[recording]);
+        } catch (...) {
+            failure = current_exception();
+        }
+        update_end = high_resolution_clock::now();
+    }
+
+    void workerLoop() {
+        while (true) {
+            unique_lock lock(m);
+            wake.wait(lock, [this] { return stopping || has_job; });
+            if (stopping) return;
+            has_job = false;
+            lock.unlock();
+
+            run();
+
+            lock.lock();
+            working = false;
+            done.notify_all();
+        }
+    }
+
+public:
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator =(const FramePipeline&) = delete;
+
+    ~FramePipeline() {
+        {
+            lock_guard lock(m);
+            stopping = true;
+        }
+        wake.notify_all();
+    }
+
+    static FramePipeline& instance() {
+        static FramePipeline pipeline;
+        return pipeline;
+    }
+
+    /*
+     * what runs every frame off of the main thread, it gets the frame's delta and the list to record into
+     * it cant touch the gpu or ask raylib about input, whoever launches it has to capture the keybinds for it
+     */
+    void start(job_t update, const bool threaded = true) {
+        job = std::move(update);
+        enabled = threaded;
+        if (enabled && !worker.joinable()) worker = jthread([this] { workerLoop(); });
+    }
+
+    //starts the next frame's update
+    void launch(const double delta) {
+        job_delta = delta;
+        if (!enabled) {
+            run();
+            return;
+        }
+        {
+            lock_guard lock(m);
+            has_job = true;
+            working = true;
+        }
+        wake.notify_all();
+    }
+
+    //waits for the update that launch() started and hands back the list it recorded
+    RenderCommandList& sync() {
+        if (enabled) {
+            unique_lock lock(m);
+            done.wait(lock, [this] { return !working; });
+        }
+        if (failure) rethrow_exception(exchange(failure, nullptr));
+
+        //how much of the update happened while the last frame was being rendered
+        const auto overlap = std::min(update_end, render_end) - std::max(update_start, render_start);
+        stats.update_ms = stats.update_ms * 0.9 + ms(update_end - update_start) * 0.1;
+        stats.render_ms = stats.render_ms * 0.9 + ms(render_end - render_start) * 0.1;
+        stats.overlap_ms = stats.overlap_ms * 0.9 + std::max(0.0, ms(overlap)) * 0.1;
+
+        RenderCommandList& ret = lists[recording];
+        recording = 1 - recording;
+        return ret;
+    }
+
+    //call around everything the main thread does with the list sync() gave back
+    void beginRender() {
+        render_start = high_resolution_clock::now();
+    }
+
+    void endRender() {
+        render_end = high_resolution_clock::now();
+    }
+
+    [[nodiscard]] bool threaded() const {
+        return enabled;
+    }
+
+    [[nodiscard]] const PipelineStats& lastStats() const {
+        return stats;
+    }
+};
+
+#endif
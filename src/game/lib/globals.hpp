@@ -10,6 +10,8 @@ inline float win_scale;
 inline fvec2 win_res;
 inline fvec2 win_pos;
 inline float zoom = 4.0;
+inline bool bake_lightmaps_on_load = false;//set with --bake-lightmaps, bakes any missing or stale lightmap when a level loads
+inline bool depth_sorting = false;//from settings.json, levels let the depth buffer order sprites instead of sorting them (see DepthSorter)
 
 inline RenderTexture2D rbuf;
 
@@ -30,24 +32,20 @@ const ivec2 base_resolution = {1280, 720};
                SetExitKey(0);\
                rbuf = Allocator::allocateRenderTexture(base_resolution.x, base_resolution.y);\
                double delta = 0;\
-               high_resolution_clock::time_point frame_start;\
-               high_resolution_clock::time_point frame_end;\
 
 #define UPDATE_DELTA() running = !WindowShouldClose();\
-                       delta = duration_cast<nanoseconds>(frame_end-frame_start).count()/1e9;\
-                       frame_start = high_resolution_clock::now();\
+                       delta = FramePacer::instance().beginFrame();\
                        if (paused) delta = 0.0;\
                        game.delta = delta;\
                        game.runtime += delta;\
 
-#define UPDATE_DELTA_EDITOR() delta = duration_cast<nanoseconds>(frame_end-frame_start).count()/1e9;\
-                              frame_start = high_resolution_clock::now();\
+#define UPDATE_DELTA_EDITOR() delta = FramePacer::instance().beginFrame();\
                               if (paused) delta = 0.0;\
 
 
 
 #define DRAW_GAME_CONTENT(texture) DrawTexturePro(texture,\
-                                   rect{0, 0, base_resolution.x, -base_resolution.y},\
+                                   rect{0, 0, (texture).width, -(texture).height},\
                                    rect{win_pos.x, win_pos.y, win_res.x, win_res.y}, {0, 0}, 0, WHITE);\
 
 #endif
@@ -0,0 +1,93 @@
+#ifndef HOT_RELOAD_HPP
+#define HOT_RELOAD_HPP
+
+#include "utils.hpp"
+#include "level_binary.hpp"
+#include "file_watcher.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+//what changed since the last HotReload::update()
+struct HotReloadChanges {
+    bool textures = false;
+    bool animations = false;
+    vector<string> levels;//level files that changed, nothing reloads these on its own
+};
+
+/*
+ * reloads textures and animations when their files change, so the art can be worked on while the game (or the
+ * editor) is running
+ * only what changed gets loaded again, textures keep their gpu handle when they can and animations are changed in
+ * place, so everything holding them sees the change without having to be told
+ * the loose files are what gets watched, so nothing is watched when the asset pack is open
+ */
+class HotReload {
+    FileWatcher watcher;
+
+    logger LHotReload = logger("hot-reload");
+
+    HotReload() = default;
+
+public:
+    static constexpr double settle_ms = 100;//how long a file has to stay the same before it gets reloaded
+
+    HotReload(const HotReload&) = delete;
+    HotReload& operator =(const HotReload&) = delete;
+
+    static HotReload& instance() {
+        static HotReload reload;
+        return reload;
+    }
+
+    void start() {
+        if (AssetPack::instance().isOpen()) {
+            LHotReload.info("Assets are coming out of the asset pack, changed files wont be reloaded");
+            return;
+        }
+        if (watcher.start({"resources", "data"})) LHotReload.info("Watching resources and data for changes");
+        else LHotReload.warn("Could not watch resources or data, changed files wont be reloaded");
+    }
+
+    void stop() {
+        watcher.stop();
+    }
+
+    [[nodiscard]] bool watching() const {
+        return watcher.watching();
+    }
+
+    //true while files changed that havent been reloaded yet
+    [[nodiscard]] bool pending() const {
+        return watcher.pending();
+    }
+
+    //once a frame on the main thread, while nothing else is using textures or animations
+    HotReloadChanges update() {
+        HotReloadChanges ret;
+        if (!watcher.pending()) return ret;
+        for (const auto& path: watcher.take(settle_ms)) {
+            const filesystem::path p(path);
+            try {
+                if (path.starts_with("resources/") && p.extension() == ".png") {
+                    Allocator::reloadTexture(path);
+                    ret.textures = true;
+                } else if (path.starts_with("data/animation/") && p.extension() == ".json") {
+                    AnimationRegistry::Instance().reloadAnimation(p.stem().generic_string());
+                    ret.animations = true;
+                } else if (p.extension() == ".json" || BinaryLevelFile::isBinary(path)) {
+                    ret.levels.push_back(path);
+                    continue;
+                } else {
+                    continue;
+                }
+                LHotReload.info("Reloaded ", path);
+            } catch (const exception& e) {
+                LHotReload.warn("Could not reload ", path, ": ", e.what());
+            }
+        }
+        return ret;
+    }
+};
+
+#endif
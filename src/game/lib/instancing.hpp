@@ -0,0 +1,89 @@
+#ifndef INSTANCING_HPP
+#define INSTANCING_HPP
+
+#include <bit>
+#include <rlgl.h>
+#include "utils.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+//where one member of an instance struct goes in the vertex shader, every member has to be made of floats
+struct InstanceAttribute {
+    u32 location;//layout(location = ...) in the vertex shader
+    i32 components;//how many floats
+    i32 offset;//byte offset into the instance struct
+};
+
+/*
+ * draws a unit quad once per instance with a single draw call, the instances are streamed in every time it's drawn
+ * the quad's corner (0-1 on both axes) is at location 0 in the vertex shader, followed by whatever attributes the
+ * instance struct has
+ * has to be initialized after the window is created
+ */
+template<typename T>
+class InstanceBuffer {
+    u32 vao = 0;
+    u32 quad_vbo = 0;
+    u32 instance_vbo = 0;
+    usize capacity = 0;
+    vector<InstanceAttribute> attributes;
+
+    void allocate(const usize instances) {
+        rlEnableVertexArray(vao);
+        if (instance_vbo) rlUnloadVertexBuffer(instance_vbo);
+        instance_vbo = rlLoadVertexBuffer(nullptr, cast(instances*sizeof(T), i32), true);
+        for (const auto& a: attributes) {
+            rlSetVertexAttribute(a.location, a.components, RL_FLOAT, false, sizeof(T), a.offset);
+            rlEnableVertexAttribute(a.location);
+            rlSetVertexAttributeDivisor(a.location, 1);
+        }
+        rlDisableVertexArray();
+        capacity = instances;
+    }
+
+public:
+    static constexpr u32 corner_location = 0;
+
+    void init(const vector<InstanceAttribute>& attrs, const usize initial_capacity = 256) {
+        attributes = attrs;
+        vao = rlLoadVertexArray();
+        rlEnableVertexArray(vao);
+        //two triangles
+        constexpr float corners[] = {0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1};
+        quad_vbo = rlLoadVertexBuffer(corners, sizeof(corners), false);
+        rlSetVertexAttribute(corner_location, 2, RL_FLOAT, false, 0, 0);
+        rlEnableVertexAttribute(corner_location);
+        rlDisableVertexArray();
+        allocate(initial_capacity);
+    }
+
+    [[nodiscard]] bool initialized() const {
+        return vao != 0;
+    }
+
+    //draws every instance with whatever shader is enabled, anything raylib still has batched should be drawn first
+    void draw(const T* instances, const usize count) {
+        if (count == 0) return;
+        if (count > capacity) allocate(std::bit_ceil(count));
+        rlEnableVertexArray(vao);
+        rlUpdateVertexBuffer(instance_vbo, instances, cast(count*sizeof(T), i32), 0);
+        rlDrawVertexArrayInstanced(0, 6, cast(count, i32));
+        rlDisableVertexArray();
+    }
+
+    void draw(const vector<T>& instances) {
+        draw(instances.data(), instances.size());
+    }
+
+    void unload() {
+        if (!vao) return;
+        rlUnloadVertexBuffer(instance_vbo);
+        rlUnloadVertexBuffer(quad_vbo);
+        rlUnloadVertexArray(vao);
+        vao = quad_vbo = instance_vbo = 0;
+        capacity = 0;
+    }
+};
+
+#endif
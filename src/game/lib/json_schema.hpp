@@ -0,0 +1,151 @@
+#ifndef JSON_SCHEMA_HPP
+#define JSON_SCHEMA_HPP
+
+#include "utils.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+//the values a number in the json is allowed to have, both ends included
+struct JsonRange {
+    double min = -numeric_limits<double>::infinity();
+    double max = numeric_limits<double>::infinity();
+};
+
+//reads one json value into a member, returns what was wrong with it (or nullptr if nothing was)
+namespace json_field {
+    inline const char* read(const json& v, bool& out, JsonRange) {
+        if (!v.is_boolean()) return "has to be true or false";
+        out = v.get<bool>();
+        return nullptr;
+    }
+
+    template<typename N> requires is_arithmetic_v<N> && (!is_same_v<N, bool>)
+    const char* read(const json& v, N& out, const JsonRange range) {
+        if (!v.is_number()) return "has to be a number";
+        if (is_integral_v<N> && !v.is_number_integer()) return "has to be a whole number";
+        const auto x = v.get<double>();
+        if (x < range.min || x > range.max) return "is out of range";
+        if (x < cast(numeric_limits<N>::lowest(), double) || x > cast(numeric_limits<N>::max(), double)) {
+            return "is out of range";
+        }
+        out = v.get<N>();
+        return nullptr;
+    }
+
+    template<typename E> requires is_enum_v<E>
+    const char* read(const json& v, E& out, const JsonRange range) {
+        underlying_type_t<E> x{};
+        if (const char* error = read(v, x, range)) return error;
+        out = cast(x, E);
+        return nullptr;
+    }
+
+    inline const char* read(const json& v, str& out, JsonRange) {
+        if (!v.is_string()) return "has to be a string";
+        out = v.get_ref<const string&>();
+        return nullptr;
+    }
+
+    //exactly N numbers
+    template<usize N>
+    bool readNumbers(const json& v, array<double, N>& out) {
+        if (!v.is_array() || v.size() != N) return false;
+        for (usize i = 0; i < N; i++) {
+            if (!v[i].is_number()) return false;
+            out[i] = v[i].get<double>();
+        }
+        return true;
+    }
+
+    //x, y, w, h
+    inline const char* read(const json& v, rect& out, JsonRange) {
+        array<double, 4> n{};
+        if (!readNumbers(v, n)) return "has to be 4 numbers";
+        out = {n[0], n[1], n[2], n[3]};
+        return nullptr;
+    }
+
+    inline const char* read(const json& v, dvec2& out, JsonRange) {
+        array<double, 2> n{};
+        if (!readNumbers(v, n)) return "has to be 2 numbers";
+        out = {n[0], n[1]};
+        return nullptr;
+    }
+
+    //r, g, b and optionally a, from 0 to 255, or from 0 to 1 if any of them has a decimal point (older levels)
+    inline const char* read(const json& v, Color& out, JsonRange) {
+        if (!v.is_array() || (v.size() != 3 && v.size() != 4)) return "has to be 3 or 4 numbers";
+        array<u8, 4> c = {0, 0, 0, 255};
+        if (ranges::any_of(v, [](const json& n) { return n.is_number_float(); })) {
+            for (usize i = 0; i < v.size(); i++) {
+                if (!v[i].is_number()) return "has to be 3 or 4 numbers";
+                c[i] = cast(std::clamp(v[i].get<double>(), 0.0, 1.0)*255, u8);
+            }
+            out = {c[0], c[1], c[2], c[3]};
+            return nullptr;
+        }
+        for (usize i = 0; i < v.size(); i++) {
+            if (const char* error = read(v[i], c[i], {0, 255})) return error;
+        }
+        out = {c[0], c[1], c[2], c[3]};
+        return nullptr;
+    }
+}
+
+/*
+ * what an object's json looks like, so factories dont have to check and read every field by hand
+ * the fields get read into a plain struct (T), its member initializers are the defaults
+ * reading goes over the json's members once, without copying any of them, members the schema doesnt have (like
+ * "type") are skipped, a field with the wrong type or out of its range throws and so does a required one that's missing
+ */
+template<typename T>
+class JsonSchema {
+    struct entry {
+        const char* name;
+        function<const char*(T&, const json&)> read;
+        bool required;
+    };
+
+    vector<entry> fields;
+
+    template<typename M>
+    JsonSchema& add(const char* name, M T::* member, const JsonRange range, const bool required) {
+        if (fields.size() >= 64) throw Exception("A json schema can only have 64 fields");
+        fields.push_back({name, [member, range](T& out, const json& v) {
+            return json_field::read(v, out.*member, range);
+        }, required});
+        return *this;
+    }
+
+public:
+    template<typename M>
+    JsonSchema& field(const char* name, M T::* member, const JsonRange range = {}) {
+        return add(name, member, range, false);
+    }
+
+    template<typename M>
+    JsonSchema& required(const char* name, M T::* member, const JsonRange range = {}) {
+        return add(name, member, range, true);
+    }
+
+    [[nodiscard]] T read(const json& data) const {
+        if (!data.is_object()) throw Exception("Expected an object, got ", data.type_name());
+        T ret;
+        u64 found = 0;
+        for (const auto& [key, value]: data.items()) {
+            for (usize i = 0; i < fields.size(); i++) {
+                if (key != fields[i].name) continue;
+                if (const char* error = fields[i].read(ret, value)) throw Exception("Field ", key, " ", error);
+                found |= u64{1} << i;
+                break;
+            }
+        }
+        for (usize i = 0; i < fields.size(); i++) {
+            if (fields[i].required && !(found & u64{1} << i)) throw Exception("Field ", fields[i].name, " is missing");
+        }
+        return ret;
+    }
+};
+
+#endif
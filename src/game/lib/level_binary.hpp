@@ -0,0 +1,309 @@
+#ifndef LEVEL_BINARY_HPP
+#define LEVEL_BINARY_HPP
+
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include "utils.hpp"
+#include "mapped_file.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+/*
+ * the binary level format, a level saved as <name>.lvl instead of <name>.json
+ * the file goes:
+ *  - the header
+ *  - the type table, one entry for every type of object in the level
+ *  - the order table, which type every object is in the order they were saved (so ids come out the same)
+ *  - the reference table, every animation the level uses, so their textures can be loaded before the objects are made
+ *  - the records, every type's objects packed together as fixed size structs (the type's factory's record)
+ *  - the string table, every string (texture ids and such) once, records point into it
+ * every section starts 8 byte aligned, so records can be read straight out of the mapped file without copying them
+ * numbers are stored however the machine that saved it stores them, it's meant for shipping levels, not for
+ * sharing between platforms, the json files are still the source
+ *
+ * object types whose factory doesnt have a record get saved as their json text instead, so every type can be saved,
+ * just not all of them quickly
+ */
+
+//a string in the level's string table
+struct BinaryString {
+    u32 offset = 0;
+    u32 size = 0;
+};
+
+//a rect as it's stored in a record
+struct BinaryRect {
+    double x = 0, y = 0, w = 0, h = 0;
+
+    static BinaryRect of(const rect& r) {
+        return {r.x, r.y, r.w, r.h};
+    }
+
+    [[nodiscard]] rect toRect() const {
+        return {x, y, w, h};
+    }
+};
+
+struct BinaryLevelHeader {
+    array<char, 4> magic{};
+    u32 version = 0;
+    u32 type_count = 0;
+    u32 object_count = 0;
+    u64 types_offset = 0;
+    u64 order_offset = 0;
+    u64 strings_offset = 0;
+    u64 strings_size = 0;
+    BinaryString name;
+    u64 references_offset = 0;
+    u32 reference_count = 0;
+    u32 unused = 0;
+};
+
+struct BinaryTypeEntry {
+    BinaryString id;//the type's registry id
+    u32 record_size = 0;
+    u32 count = 0;
+    u64 records_offset = 0;
+    u32 json = 0;//1 if the records are BinaryStrings pointing to the objects' json
+    u32 unused = 0;
+};
+
+static_assert(sizeof(BinaryLevelHeader) == 72 && sizeof(BinaryTypeEntry) == 32);
+
+inline constexpr array<char, 4> binary_level_magic = {'J', 'O', 'B', 'L'};
+inline constexpr u32 binary_level_version = 2;
+
+//builds a binary level, objects have to be added in the order they should be loaded in
+class BinaryLevelWriter {
+    struct type_block {
+        string id;
+        u32 record_size;
+        bool json;
+        vector<byte> records;
+        u32 count = 0;
+    };
+
+    string name;
+    vector<type_block> types;
+    unordered_map<string, u16> type_index;
+    vector<u16> order;
+    vector<BinaryString> references;
+    vector<char> strings;
+    unordered_map<string, BinaryString> interned;//texture ids repeat a lot
+
+    void addRecord(const string& type_id, const void* record, const u32 size, const bool json) {
+        auto it = type_index.find(type_id);
+        if (it == type_index.end()) {
+            if (types.size() > numeric_limits<u16>::max()) throw Exception("Too many object types for a binary level");
+            it = type_index.emplace(type_id, cast(types.size(), u16)).first;
+            types.push_back({type_id, size, json});
+        }
+        type_block& t = types[it->second];
+        if (t.record_size != size || t.json != json) {
+            throw Exception("Objects of type ", type_id, " dont all have the same kind of record");
+        }
+        const auto* bytes = cast(record, const byte*);
+        t.records.insert(t.records.end(), bytes, bytes + size);
+        t.count++;
+        order.push_back(it->second);
+    }
+
+    static u64 align(const u64 offset) {
+        return (offset + 7) & ~u64{7};
+    }
+
+public:
+    explicit BinaryLevelWriter(const string& level_name) {
+        name = level_name;
+    }
+
+    //puts the string in the string table (once), records keep what this gives back
+    BinaryString addString(const string_view s) {
+        const auto it = interned.find(string(s));
+        if (it != interned.end()) return it->second;
+        const BinaryString ret = {cast(strings.size(), u32), cast(s.size(), u32)};
+        strings.insert(strings.end(), s.begin(), s.end());
+        interned.emplace(string(s), ret);
+        return ret;
+    }
+
+    template<typename R> requires is_trivially_copyable_v<R> && is_standard_layout_v<R>
+    void add(const string& type_id, const R& record) {
+        addRecord(type_id, &record, sizeof(R), false);
+    }
+
+    //an animation the level uses
+    void addReference(const string_view animation_id) {
+        references.push_back(addString(animation_id));
+    }
+
+    //for types without a record
+    void addJson(const string& type_id, const json& data) {
+        const BinaryString text = addString(data.dump());
+        addRecord(type_id, &text, sizeof(BinaryString), true);
+    }
+
+    void save(const string& path) {
+        BinaryLevelHeader header;
+        header.magic = binary_level_magic;
+        header.version = binary_level_version;
+        header.type_count = cast(types.size(), u32);
+        header.object_count = cast(order.size(), u32);
+        header.reference_count = cast(references.size(), u32);
+
+        //the string table is written last, but the type ids and the name have to be in it first
+        header.name = addString(name);
+        vector<BinaryTypeEntry> entries(types.size());
+        for (usize i = 0; i < types.size(); i++) {
+            entries[i].id = addString(types[i].id);
+            entries[i].record_size = types[i].record_size;
+            entries[i].count = types[i].count;
+            entries[i].json = types[i].json;
+        }
+
+        u64 offset = align(sizeof(BinaryLevelHeader));
+        header.types_offset = offset;
+        offset = align(offset + entries.size() * sizeof(BinaryTypeEntry));
+        header.order_offset = offset;
+        offset = align(offset + order.size() * sizeof(u16));
+        header.references_offset = offset;
+        offset = align(offset + references.size() * sizeof(BinaryString));
+        for (usize i = 0; i < types.size(); i++) {
+            entries[i].records_offset = offset;
+            offset = align(offset + types[i].records.size());
+        }
+        header.strings_offset = offset;
+        header.strings_size = strings.size();
+
+        ofstream out(path, ios::binary | ios::trunc);
+        if (!out.is_open()) throw Exception("Could not write binary level ", path);
+        const auto write = [&out](const void* data, const u64 size) {
+            out.write(cast(data, const char*), cast(size, streamsize));
+        };
+        const auto pad = [&out] {
+            constexpr array<char, 8> zeros{};
+            const auto at = cast(out.tellp(), u64);
+            out.write(zeros.data(), cast(align(at) - at, streamsize));
+        };
+        write(&header, sizeof(header));
+        pad();
+        write(entries.data(), entries.size() * sizeof(BinaryTypeEntry));
+        pad();
+        write(order.data(), order.size() * sizeof(u16));
+        pad();
+        write(references.data(), references.size() * sizeof(BinaryString));
+        pad();
+        for (const auto& t: types) {
+            write(t.records.data(), t.records.size());
+            pad();
+        }
+        write(strings.data(), strings.size());
+        out.close();
+        if (!out) throw Exception("Could not write binary level ", path);
+    }
+};
+
+//a binary level mapped into memory, everything it gives back points into the file so it has to outlive them
+class BinaryLevelFile {
+    string path;
+    MappedFile file;
+    const BinaryLevelHeader* header = nullptr;
+    span<const BinaryTypeEntry> type_table;
+    span<const u16> order_table;
+    span<const BinaryString> reference_table;
+    string_view strings;
+
+    [[nodiscard]] bool inFile(const u64 offset, const u64 size) const {
+        return offset <= file.size() && size <= file.size() - offset;
+    }
+
+    void checkString(const BinaryString s) const {
+        if (s.offset > strings.size() || s.size > strings.size() - s.offset) {
+            throw Exception("Binary level ", path, " is corrupt (string)");
+        }
+    }
+
+    template<typename T>
+    const T* at(const u64 offset, const u64 count, const char* what) const {
+        if (offset % alignof(T) != 0 || !inFile(offset, count * sizeof(T))) {
+            throw Exception("Binary level ", path, " is corrupt (", what, ")");
+        }
+        return reinterpret_cast<const T*>(file.data() + offset);
+    }
+
+public:
+    static constexpr const char* extension = ".lvl";
+
+    static bool isBinary(const string& level_path) {
+        return filesystem::path(level_path).extension() == extension;
+    }
+
+    explicit BinaryLevelFile(const string& level_path) : path(level_path) {
+        if (!file.open(path)) throw Exception("Could not open binary level ", path);
+        header = at<BinaryLevelHeader>(0, 1, "header");
+        if (header->magic != binary_level_magic) throw Exception(path, " is not a binary level");
+        if (header->version != binary_level_version) {
+            throw Exception("Binary level ", path, " is version ", header->version, ", expected ",
+                            binary_level_version);
+        }
+        type_table = {at<BinaryTypeEntry>(header->types_offset, header->type_count, "types"), header->type_count};
+        order_table = {at<u16>(header->order_offset, header->object_count, "order"), header->object_count};
+        reference_table = {at<BinaryString>(header->references_offset, header->reference_count, "references"),
+                           header->reference_count};
+        strings = {at<char>(header->strings_offset, header->strings_size, "strings"), header->strings_size};
+
+        //everything records point to gets checked once here, so reading them later doesnt have to
+        u64 objects = 0;
+        for (const auto& t: type_table) {
+            checkString(t.id);
+            at<byte>(t.records_offset, cast(t.record_size, u64) * t.count, "records");
+            if (t.records_offset % 8 != 0) throw Exception("Binary level ", path, " is corrupt (records)");
+            objects += t.count;
+        }
+        vector<u32> seen(type_table.size());
+        for (const u16 t: order_table) {
+            if (t >= type_table.size() || ++seen[t] > type_table[t].count) {
+                throw Exception("Binary level ", path, " is corrupt (order)");
+            }
+        }
+        if (objects != order_table.size()) throw Exception("Binary level ", path, " is corrupt (counts)");
+        checkString(header->name);
+        for (const auto& r: reference_table) checkString(r);
+    }
+
+    BinaryLevelFile(const BinaryLevelFile&) = delete;
+    BinaryLevelFile& operator =(const BinaryLevelFile&) = delete;
+
+    [[nodiscard]] string_view text(const BinaryString s) const {
+        checkString(s);
+        return strings.substr(s.offset, s.size);
+    }
+
+    [[nodiscard]] string_view name() const {
+        return text(header->name);
+    }
+
+    [[nodiscard]] span<const BinaryTypeEntry> types() const {
+        return type_table;
+    }
+
+    //the type (an index into types()) of every object, in the order they were saved
+    [[nodiscard]] span<const u16> order() const {
+        return order_table;
+    }
+
+    //the ids of every animation the level uses
+    [[nodiscard]] span<const BinaryString> references() const {
+        return reference_table;
+    }
+
+    //the index-th record of the type, straight out of the file
+    [[nodiscard]] const byte* record(const u16 type, const usize index) const {
+        const BinaryTypeEntry& t = type_table[type];
+        return file.data() + t.records_offset + index * t.record_size;
+    }
+};
+
+#endif
@@ -0,0 +1,248 @@
+#ifndef LEVEL_STREAM_HPP
+#define LEVEL_STREAM_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include "utils.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+/*
+ * reads a json level as it's parsed instead of parsing the whole file into a json first, every element of "objects"
+ * is handed out as soon as it closes and is gone once on_object is done with it, so only one object is ever in memory
+ * everything besides "name" and "objects" at the top of the file is skipped
+ */
+class LevelJsonReader : public nlohmann::json_sax<json> {
+    std::string path;//only for errors, the string() event below hides the type's name in here
+    function<void(std::string)> on_name;
+    function<bool(json&)> on_object;//returning false stops the parse
+
+    usize depth = 0;//how deep we are outside of the object being built
+    std::string top_key;//the last key of the top level object
+    bool in_objects = false;
+    bool has_name = false;
+    bool has_objects = false;
+
+    json element;//the object being built
+    vector<json*> building;//the containers in it that are still open, innermost last
+    std::string element_key;//the key of the next value in the innermost open object
+
+    [[nodiscard]] bool collecting() const {
+        return in_objects && depth == 2;
+    }
+
+    json* place(json&& v) {
+        if (building.empty()) {
+            element = std::move(v);
+            return &element;
+        }
+        json& parent = *building.back();
+        if (parent.is_array()) {
+            parent.push_back(std::move(v));
+            return &parent.back();
+        }
+        return &(parent[element_key] = std::move(v));
+    }
+
+    bool finishElement() {
+        const bool keep_going = on_object(element);
+        element = nullptr;
+        return keep_going;
+    }
+
+    bool value(json&& v) {
+        if (collecting()) {
+            place(std::move(v));
+            return !building.empty() || finishElement();
+        }
+        if (depth == 1 && top_key == "name" && v.is_string()) {
+            has_name = true;
+            on_name(v.get<std::string>());
+        }
+        return true;
+    }
+
+    bool open(json&& container) {
+        if (collecting()) {
+            building.push_back(place(std::move(container)));
+            return true;
+        }
+        if (depth == 1 && top_key == "objects" && container.is_array()) {
+            in_objects = true;
+            has_objects = true;
+        }
+        depth++;
+        return true;
+    }
+
+    bool close() {
+        if (!building.empty()) {
+            building.pop_back();
+            return !building.empty() || finishElement();
+        }
+        depth--;
+        if (depth == 1) in_objects = false;
+        return true;
+    }
+
+public:
+    LevelJsonReader(std::string level_path, function<void(std::string)> name, function<bool(json&)> object) :
+        path(std::move(level_path)), on_name(std::move(name)), on_object(std::move(object)) {}
+
+    bool null() override { return value(nullptr); }
+    bool boolean(const bool val) override { return value(val); }
+    bool number_integer(const number_integer_t val) override { return value(val); }
+    bool number_unsigned(const number_unsigned_t val) override { return value(val); }
+    bool number_float(const number_float_t val, const string_t&) override { return value(val); }
+    bool string(string_t& val) override { return value(std::move(val)); }
+    bool binary(binary_t& val) override { return value(json::binary(std::move(val))); }
+
+    bool start_object(std::size_t) override { return open(json::object()); }
+    bool end_object() override { return close(); }
+    bool start_array(std::size_t) override { return open(json::array()); }
+    bool end_array() override { return close(); }
+
+    bool key(string_t& val) override {
+        if (!building.empty()) element_key = std::move(val);
+        else if (depth == 1) top_key = std::move(val);
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const json::exception& ex) override {
+        throw Exception("Could not parse level ", path, ": ", ex.what());
+    }
+
+    //once the whole file was read, a level needs a name and its objects
+    void finish() const {
+        if (!has_name) throw Exception("Level ", path, " has no name");
+        if (!has_objects) throw Exception("Level ", path, " has no objects");
+    }
+};
+
+/*
+ * parses a json level on its own thread (see LevelJsonReader) while the main thread makes the objects a few at a
+ * time, the parser waits once queue_size objects are ready so memory stays the same no matter how big the level is
+ */
+class LevelStream {
+    //a file read in big chunks, counting how much of it has been read so the progress can be checked from outside
+    class CountingFileBuf : public streambuf {
+        filebuf file;
+        array<char, 65536> buffer{};
+        atomic<usize>& read_bytes;
+
+    protected:
+        int_type underflow() override {
+            const streamsize n = file.sgetn(buffer.data(), cast(buffer.size(), streamsize));
+            if (n <= 0) return traits_type::eof();
+            read_bytes.fetch_add(cast(n, usize), memory_order_relaxed);
+            setg(buffer.data(), buffer.data(), buffer.data() + n);
+            return traits_type::to_int_type(buffer[0]);
+        }
+
+    public:
+        CountingFileBuf(const string& path, atomic<usize>& read) : read_bytes(read) {
+            file.open(path, ios::in | ios::binary);
+        }
+
+        [[nodiscard]] bool isOpen() const {
+            return file.is_open();
+        }
+    };
+
+    string path;
+    usize total_bytes = 0;
+    atomic<usize> read_bytes{0};
+
+    mutex m;
+    condition_variable space;
+    deque<json> ready;
+    string name;
+    bool done = false;
+    bool cancelled = false;
+    exception_ptr error;
+
+    jthread thread;//last, so it's joined before anything it uses is destroyed
+
+    void run() {
+        try {
+            CountingFileBuf buf(path, read_bytes);
+            if (!buf.isOpen()) throw Exception("Could not create level from file ", path);
+            istream in(&buf);
+            LevelJsonReader reader(path, [this](string n) {
+                lock_guard lock(m);
+                name = std::move(n);
+            }, [this](json& obj) {
+                unique_lock lock(m);
+                space.wait(lock, [this] { return cancelled || ready.size() < queue_size; });
+                if (cancelled) return false;
+                ready.push_back(std::move(obj));
+                return true;
+            });
+            //false means it was cancelled
+            if (json::sax_parse(in, &reader)) reader.finish();
+        } catch (...) {
+            lock_guard lock(m);
+            error = current_exception();
+        }
+        lock_guard lock(m);
+        done = true;
+    }
+
+public:
+    static constexpr usize queue_size = 256;
+
+    explicit LevelStream(string level_path) : path(std::move(level_path)) {
+        error_code ec;
+        total_bytes = cast(filesystem::file_size(path, ec), usize);
+        if (ec) total_bytes = 0;
+        thread = jthread([this] { run(); });
+    }
+
+    LevelStream(const LevelStream&) = delete;
+    LevelStream& operator =(const LevelStream&) = delete;
+
+    ~LevelStream() {
+        {
+            lock_guard lock(m);
+            cancelled = true;
+        }
+        space.notify_all();
+    }
+
+    /*
+     * moves up to max of the objects that are ready into out without waiting for more, returns false once the whole
+     * file was parsed and every object was taken
+     * anything that went wrong while parsing gets thrown from here
+     */
+    bool take(vector<json>& out, const usize max) {
+        lock_guard lock(m);
+        if (error) rethrow_exception(error);
+        while (!ready.empty() && out.size() < max) {
+            out.push_back(std::move(ready.front()));
+            ready.pop_front();
+        }
+        space.notify_all();
+        return !done || !ready.empty();
+    }
+
+    //the level's name, empty until the parser gets to it
+    [[nodiscard]] string levelName() {
+        lock_guard lock(m);
+        return name;
+    }
+
+    //how much of the file has been parsed, from 0 to 1
+    [[nodiscard]] double progress() const {
+        if (total_bytes == 0) return 0;
+        return std::min(1.0, cast(read_bytes.load(memory_order_relaxed), double) / cast(total_bytes, double));
+    }
+};
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef LIGHT_TILES_HPP
+#define LIGHT_TILES_HPP
+
+#include <rlgl.h>
+#include "utils.hpp"
+#include "workers.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+/*
+ * splits the area being lit into tiles and works out which lights touch each tile, so the lighting shader only
+ * has to look at the lights that can actually reach a pixel instead of every light on screen
+ * the lists are built on the cpu every frame (spread across the worker pool, a band of tile rows each) and handed
+ * to the shader as three float textures:
+ *  - lights: every light as two texels, (x, y, w, h) and (r, g, b, intensity), same layout as the light struct
+ *  - tile lights: every tile's light indices one after another
+ *  - tiles: where each tile's indices start and how many there are
+ * T has to be 8 floats laid out like that
+ */
+template<typename T>
+class LightTileGrid {
+public:
+    static constexpr i32 tile_size = 32;
+    static constexpr i32 data_width = 4096;//the width of the data textures, the shader wraps indices with it
+
+private:
+    struct data_texture {
+        u32 id = 0;
+        i32 width = 0;
+        i32 height = 0;
+        i32 format = 0;
+
+        //grows the texture to fit at least rows rows, the contents are gone afterward
+        void reserve(const i32 w, const i32 rows, const i32 fmt) {
+            if (id && w == width && rows <= height && fmt == format) return;
+            if (id) rlUnloadTexture(id);
+            width = w;
+            height = std::max(rows, std::max(height, 1));
+            format = fmt;
+            id = rlLoadTexture(nullptr, width, height, format, 1);
+        }
+
+        void upload(const void* data, const i32 rows) const {
+            if (rows > 0) rlUpdateTexture(id, 0, 0, width, rows, format, data);
+        }
+
+        void unload() {
+            if (id) rlUnloadTexture(id);
+            id = 0;
+            width = height = 0;
+        }
+    };
+
+    i32 tiles_x = 0;
+    i32 tiles_y = 0;
+    vector<vector<u32>> bins;//light indices per tile
+    vector<float> light_data;
+    vector<float> tile_ranges;//offset, count, unused, unused per tile
+    vector<float> tile_lights;
+
+    data_texture lights_texture;
+    data_texture tiles_texture;
+    data_texture tile_lights_texture;
+
+    static i32 rowsFor(const usize texels) {
+        return cast((texels + data_width - 1) / data_width, i32);
+    }
+
+public:
+    static_assert(sizeof(T) == sizeof(float) * 8, "lights have to be 8 floats");
+
+    LightTileGrid() = default;
+
+    LightTileGrid(const LightTileGrid&) = delete;
+    LightTileGrid& operator =(const LightTileGrid&) = delete;
+
+    /*
+     * bins every light into the tiles it overlaps and uploads everything for the shader
+     * space is the size of the area the lights are in, it gets split into tile_size sized tiles
+     */
+    void build(const vector<T>& lights, const fvec2 space) {
+        tiles_x = std::max(1, cast(std::ceil(space.x / tile_size), i32));
+        tiles_y = std::max(1, cast(std::ceil(space.y / tile_size), i32));
+        const usize tile_count = cast(tiles_x, usize) * tiles_y;
+        if (bins.size() != tile_count) bins.assign(tile_count, {});
+
+        auto& pool = WorkerPool::instance();
+        const usize bands = std::min(pool.concurrency(), cast(tiles_y, usize));
+        auto bandRows = [this, bands](const usize band) {
+            return pair{cast(band * tiles_y / bands, i32), cast((band + 1) * tiles_y / bands, i32)};
+        };
+
+        //every band of rows only touches its own bins, so the threads never share anything they write to
+        pool.parallelFor(bands, [&](const usize band) {
+            const auto [row_start, row_end] = bandRows(band);
+            for (i32 ty = row_start; ty < row_end; ty++) {
+                for (i32 tx = 0; tx < tiles_x; tx++) bins[ty * tiles_x + tx].clear();
+            }
+
+            for (usize i = 0; i < lights.size(); i++) {
+                const auto* l = reinterpret_cast<const float*>(&lights[i]);
+                const i32 y1 = std::max(row_start, cast(std::floor(l[1] / tile_size), i32));
+                const i32 y2 = std::min(row_end - 1, cast(std::floor((l[1] + l[3]) / tile_size), i32));
+                if (y1 > y2) continue;
+                const i32 x1 = std::max(0, cast(std::floor(l[0] / tile_size), i32));
+                const i32 x2 = std::min(tiles_x - 1, cast(std::floor((l[0] + l[2]) / tile_size), i32));
+                for (i32 ty = y1; ty <= y2; ty++) {
+                    for (i32 tx = x1; tx <= x2; tx++) bins[ty * tiles_x + tx].push_back(cast(i, u32));
+                }
+            }
+        });
+
+        //flatten the bins into one list
+        tile_ranges.resize(tile_count * 4);
+        usize total = 0;
+        for (usize t = 0; t < tile_count; t++) {
+            tile_ranges[t*4] = cast(total, float);
+            tile_ranges[t*4 + 1] = cast(bins[t].size(), float);
+            total += bins[t].size();
+        }
+        tile_lights.resize(cast(std::max(rowsFor(total), 1), usize) * data_width);
+        pool.parallelFor(bands, [&](const usize band) {
+            const auto [row_start, row_end] = bandRows(band);
+            for (usize t = cast(row_start * tiles_x, usize); t < cast(row_end * tiles_x, usize); t++) {
+                auto out = tile_lights.begin() + cast(tile_ranges[t*4], i64);
+                for (const u32 i: bins[t]) *out++ = cast(i, float);
+            }
+        });
+
+        light_data.resize(cast(std::max(rowsFor(lights.size() * 2), 1), usize) * data_width * 4);
+        memcpy(light_data.data(), lights.data(), lights.size() * sizeof(T));
+
+        lights_texture.reserve(data_width, rowsFor(lights.size() * 2), PIXELFORMAT_UNCOMPRESSED_R32G32B32A32);
+        lights_texture.upload(light_data.data(), rowsFor(lights.size() * 2));
+        tiles_texture.reserve(tiles_x, tiles_y, PIXELFORMAT_UNCOMPRESSED_R32G32B32A32);
+        tiles_texture.upload(tile_ranges.data(), tiles_y);
+        tile_lights_texture.reserve(data_width, rowsFor(total), PIXELFORMAT_UNCOMPRESSED_R32);
+        tile_lights_texture.upload(tile_lights.data(), rowsFor(total));
+    }
+
+    //the ids of the lights, tile lights and tiles textures
+    [[nodiscard]] u32 lightsTexture() const { return lights_texture.id; }
+    [[nodiscard]] u32 tileLightsTexture() const { return tile_lights_texture.id; }
+    [[nodiscard]] u32 tilesTexture() const { return tiles_texture.id; }
+
+    [[nodiscard]] ivec2 tileCount() const {
+        return {tiles_x, tiles_y};
+    }
+
+    void unload() {
+        lights_texture.unload();
+        tiles_texture.unload();
+        tile_lights_texture.unload();
+    }
+};
+
+#endif
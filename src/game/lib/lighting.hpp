@@ -0,0 +1,382 @@
+#ifndef LIGHTING_HPP
+#define LIGHTING_HPP
+
+#include <rlgl.h>
+#include "globals.hpp"
+#include "utils.hpp"
+#include "instancing.hpp"
+#include "light_tiles.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+//one lit quad, in screen space (the same space as rbuf)
+struct LightInstance {
+    float x, y, w, h;
+    float r, g, b, intensity;
+};
+
+//what the lighting pass drew last time
+struct LightingStats {
+    usize lights = 0;
+    usize ambient = 0;
+    double tile_build_ms = 0;//binning the lights into tiles and uploading them
+    usize shadowed_lights = 0;
+};
+
+//a light that only reaches as far as its visibility polygon, see buildVisibilityPolygon()
+struct ShadowedLight {
+    LightInstance light;
+    usize first;//where the polygon starts in LightList::polygon_points
+    usize count;
+};
+
+/*
+ * everything submitted for one frame of lighting, filled by LightingPass::record() and drawn by render()
+ * it doesnt point at anything the objects own, so it can be drawn while the level is already updating again
+ */
+struct LightList {
+    vector<LightInstance> ambient;
+    vector<LightInstance> lights;
+    vector<ShadowedLight> shadowed;
+    vector<fvec2> polygon_points;//every shadowed light's polygon one after another, in screen space
+    Texture2D baked{};//has to stay alive until the list is drawn, see LightingPass::releaseAfterRender()
+    rect baked_area{};
+    bool has_baked = false;
+
+    void clear() {
+        ambient.clear();
+        lights.clear();
+        shadowed.clear();
+        polygon_points.clear();
+        has_baked = false;
+    }
+};
+
+/*
+ * the light accumulation pass, shared by the game and the editor
+ * objects submit their lighting from drawLighting(), then everything gets drawn into the light buffer in two passes:
+ *  - ambient: the light level of every floor in one instanced draw, the darkest one wins where they overlap
+ *  - lights: one fullscreen pass where every pixel adds up the lights of its tile (see LightTileGrid), so the cost
+ *    depends on how many lights overlap a pixel instead of how many lights there are
+ * lights that have walls around them get drawn on their own afterward, as their visibility polygon
+ * the light buffer starts out fully lit and the lighting post pass multiplies the scene with it
+ * a level with a baked lightmap hands that in with addBaked() instead of its static lights, it gets drawn first and
+ * whatever lights are left get added on top
+ */
+class LightingPass {
+    RenderTexture2D light_buffer{};
+    Shader shader{};
+    i32 resolution_loc = -1;
+
+    Shader tile_shader{};
+    struct {
+        i32 lights = -1;
+        i32 tile_lights = -1;
+        i32 tiles = -1;
+        i32 space = -1;
+        i32 buffer_size = -1;
+        i32 tile_size = -1;
+        i32 tile_count = -1;
+    } tile_locs;
+
+    Shader fan_shader{};
+
+    InstanceBuffer<LightInstance> ambient_quads;
+    LightTileGrid<LightInstance> tiles;
+    LightList scratch;//for render(), bake() and hash(), which record and draw in one go
+    //what add*() fills, per thread so the game can record a frame while the last one is being drawn
+    inline static thread_local LightList* recording = nullptr;
+    LightingStats last_stats;
+    float scene_scale = 1;
+    vector<Texture2D> retired;//see releaseAfterRender()
+
+    void allocateBuffer() {
+        light_buffer = Allocator::allocateRenderTexture(
+            std::max(1, cast(base_resolution.x * resolution_scale * scene_scale, i32)),
+            std::max(1, cast(base_resolution.y * resolution_scale * scene_scale, i32)));
+        SetTextureFilter(light_buffer.texture, TEXTURE_FILTER_BILINEAR);
+    }
+
+    LightingPass() {
+        allocateBuffer();
+
+        shader = Allocator::allocateShader("resources/shaders/light.vsh", "resources/shaders/light.fsh");
+        resolution_loc = GetShaderLocation(shader, "resolution");
+
+        tile_shader = Allocator::allocateShader(nullptr, "resources/shaders/light_tiles.fsh");
+        tile_locs.lights = GetShaderLocation(tile_shader, "lights");
+        tile_locs.tile_lights = GetShaderLocation(tile_shader, "tileLights");
+        tile_locs.tiles = GetShaderLocation(tile_shader, "tiles");
+        tile_locs.space = GetShaderLocation(tile_shader, "space");
+        tile_locs.buffer_size = GetShaderLocation(tile_shader, "bufferSize");
+        tile_locs.tile_size = GetShaderLocation(tile_shader, "tileSize");
+        tile_locs.tile_count = GetShaderLocation(tile_shader, "tileCount");
+
+        fan_shader = Allocator::allocateShader(nullptr, "resources/shaders/light_fan.fsh");
+
+        ambient_quads.init({
+            {1, 4, offsetof(LightInstance, x)},
+            {2, 4, offsetof(LightInstance, r)},
+        });
+    }
+
+    LightList& target() {
+        return recording ? *recording : scratch;
+    }
+
+    void drawAmbient(const LightList& list, const fvec2 space) {
+        rlEnableShader(shader.id);
+        const float resolution[2] = {space.x, space.y};
+        rlSetUniform(resolution_loc, resolution, RL_SHADER_UNIFORM_VEC2, 1);
+        ambient_quads.draw(list.ambient);
+        rlDisableShader();
+    }
+
+    void drawLights(const LightList& list, const RenderTexture2D& target, const fvec2 space) {
+        const auto build_start = high_resolution_clock::now();
+        tiles.build(list.lights, space);
+        last_stats.tile_build_ms = cast(
+            duration_cast<nanoseconds>(high_resolution_clock::now() - build_start).count(), double) / 1e6;
+
+        const float space_v[2] = {space.x, space.y};
+        const float buffer_size[2] = {cast(target.texture.width, float), cast(target.texture.height, float)};
+        const float tile_size = LightTileGrid<LightInstance>::tile_size;
+        const ivec2 count = tiles.tileCount();
+        const i32 tile_count[2] = {count.x, count.y};
+
+        BeginShaderMode(tile_shader);
+        rlSetUniformSampler(tile_locs.lights, tiles.lightsTexture());
+        rlSetUniformSampler(tile_locs.tile_lights, tiles.tileLightsTexture());
+        rlSetUniformSampler(tile_locs.tiles, tiles.tilesTexture());
+        SetShaderValue(tile_shader, tile_locs.space, space_v, SHADER_UNIFORM_VEC2);
+        SetShaderValue(tile_shader, tile_locs.buffer_size, buffer_size, SHADER_UNIFORM_VEC2);
+        SetShaderValue(tile_shader, tile_locs.tile_size, &tile_size, SHADER_UNIFORM_FLOAT);
+        SetShaderValue(tile_shader, tile_locs.tile_count, tile_count, SHADER_UNIFORM_IVEC2);
+        DrawRectangle(0, 0, target.texture.width, target.texture.height, WHITE);
+        EndShaderMode();
+    }
+
+    //every shadowed light as a triangle fan, the texture coordinates go from -1 to 1 across the light's radius
+    void drawShadowed(const LightList& list, const RenderTexture2D& target, const fvec2 space) {
+        BeginShaderMode(fan_shader);
+        rlPushMatrix();
+        rlScalef(target.texture.width / space.x, target.texture.height / space.y, 1);
+        rlSetTexture(rlGetTextureIdDefault());
+        for (const auto& s: list.shadowed) {
+            if (s.count < 2) continue;
+            const fvec2* poly = list.polygon_points.data() + s.first;
+            const float cx = s.light.x + s.light.w / 2;
+            const float cy = s.light.y + s.light.h / 2;
+            const float r = s.light.w / 2;
+
+            rlCheckRenderBatchLimit(cast(s.count * 3, i32));
+            rlBegin(RL_TRIANGLES);
+            rlColor4f(s.light.r, s.light.g, s.light.b, s.light.intensity);
+            for (usize i = 0; i < s.count; i++) {
+                const fvec2& p1 = poly[i];
+                const fvec2& p2 = poly[(i + 1) % s.count];
+                rlTexCoord2f(0, 0);
+                rlVertex2f(cx, cy);
+                //counter clockwise so backface culling leaves them alone
+                for (const fvec2* p: {&p2, &p1}) {
+                    rlTexCoord2f((p->x - cx) / r, (p->y - cy) / r);
+                    rlVertex2f(p->x, p->y);
+                }
+            }
+            rlEnd();
+        }
+        rlSetTexture(0);
+        rlPopMatrix();
+        EndShaderMode();
+    }
+
+    //draws everything in the list into target, space is the size of the area the submissions are in
+    void drawInto(const LightList& list, const RenderTexture2D& target, const fvec2 space) {
+        BeginTextureMode(target);
+        ClearBackground(WHITE);
+
+        if (list.has_baked) {
+            rlPushMatrix();
+            rlScalef(target.texture.width / space.x, target.texture.height / space.y, 1);
+            DrawTexturePro(list.baked, rect{0, 0, list.baked.width, list.baked.height}, list.baked_area, {0, 0}, 0, WHITE);
+            rlPopMatrix();
+        }
+        //anything raylib has batched up has to go first since we draw straight to the gpu
+        rlDrawRenderBatchActive();
+
+        rlSetBlendFactors(RL_ONE, RL_ONE, RL_MIN);
+        BeginBlendMode(BLEND_CUSTOM);
+        drawAmbient(list, space);
+        EndBlendMode();
+
+        last_stats.lights = list.lights.size();
+        last_stats.ambient = list.ambient.size();
+        last_stats.tile_build_ms = 0;
+        last_stats.shadowed_lights = list.shadowed.size();
+        BeginBlendMode(BLEND_ADDITIVE);
+        if (!list.lights.empty()) drawLights(list, target, space);
+        if (!list.shadowed.empty()) drawShadowed(list, target, space);
+        EndBlendMode();
+
+        EndTextureMode();
+    }
+
+public:
+    //the light buffer is smooth anyway, so it doesnt need to be full resolution
+    static constexpr float resolution_scale = 0.5f;
+
+    LightingPass(const LightingPass&) = delete;
+    LightingPass& operator =(const LightingPass&) = delete;
+
+    static LightingPass& instance() {
+        static LightingPass pass;
+        return pass;
+    }
+
+    //follows the scene when it's drawn at a lower resolution (see DynamicResolution), s is a fraction of base_resolution
+    void setScale(const float s) {
+        if (s == scene_scale) return;
+        scene_scale = s;
+        Allocator::free(light_buffer);
+        allocateBuffer();
+    }
+
+    //a light at center (screen space) fading out to nothing at radius
+    void addLight(const dvec2 center, const float radius, const Color c, const u8 light_level) {
+        const float r = abs(radius);
+        target().lights.push_back({
+            cast(center.x - r, float), cast(center.y - r, float), r*2, r*2,
+            c.r/255.0f, c.g/255.0f, c.b/255.0f, light_level/255.0f
+        });
+    }
+
+    //a baked lightmap covering the area (screen space), free it with releaseAfterRender() instead of unloading it
+    void addBaked(const Texture2D& texture, const rect& area) {
+        LightList& list = target();
+        list.baked = texture;
+        list.baked_area = area;
+        list.has_baked = true;
+    }
+
+    //a light that only reaches inside of polygon (world space, drawn at polygon - offset), center is in screen space
+    void addShadowedLight(const dvec2 center, const float radius, const Color c, const u8 light_level,
+                          const vector<dvec2>& polygon, const dvec2 offset) {
+        const float r = abs(radius);
+        LightList& list = target();
+        list.shadowed.push_back({
+            {
+                cast(center.x - r, float), cast(center.y - r, float), r*2, r*2,
+                c.r/255.0f, c.g/255.0f, c.b/255.0f, light_level/255.0f
+            },
+            list.polygon_points.size(), polygon.size()
+        });
+        for (const dvec2& p: polygon) {
+            list.polygon_points.push_back({cast(p.x - offset.x, float), cast(p.y - offset.y, float)});
+        }
+    }
+
+    //caps the light in the area (screen space) to the light level
+    void addAmbient(const rect& area, const u8 light_level) {
+        const float l = light_level/255.0f;
+        target().ambient.push_back({
+            cast(area.x, float), cast(area.y, float), cast(area.w, float), cast(area.h, float),
+            l, l, l, 1
+        });
+    }
+
+    /*
+     * clears the list and fills it with whatever submit adds, submit should call drawLighting() on whatever is being lit
+     * doesnt touch the gpu, so it can run on another thread than the one drawing (one list per thread at a time)
+     */
+    void record(LightList& into, const function<void()>& submit) {
+        LightList* previous = recording;
+        into.clear();
+        recording = &into;
+        submit();
+        recording = previous;
+    }
+
+    /*
+     * for a texture that went to addBaked(), a list recorded before it went away might still be drawn (the pipelined
+     * frame renders a list recorded during the last update), so it only gets unloaded once the next list is rendered
+     */
+    void releaseAfterRender(const Texture2D& texture) {
+        retired.push_back(texture);
+    }
+
+    //renders the light buffer from a recorded list, has to be called outside of any texture mode
+    void render(const LightList& list) {
+        drawInto(list, light_buffer, {cast(base_resolution.x, float), cast(base_resolution.y, float)});
+        for (const auto& t: retired) UnloadTexture(t);
+        retired.clear();
+    }
+
+    //records and renders in one go
+    void render(const function<void()>& submit) {
+        record(scratch, submit);
+        render(scratch);
+    }
+
+    /*
+     * renders whatever submit adds into an image instead of the light buffer, for baking lightmaps
+     * the submissions should be relative to the area's position, every pixel of the image covers texel_size units
+     * has to be called outside of any texture mode
+     */
+    Image bake(const rect& area, const double texel_size, const function<void()>& submit) {
+        record(scratch, submit);
+
+        const RenderTexture2D target = Allocator::allocateRenderTexture(
+            std::max(1, cast(std::ceil(area.w / texel_size), i32)),
+            std::max(1, cast(std::ceil(area.h / texel_size), i32)));
+        drawInto(scratch, target, {cast(area.w, float), cast(area.h, float)});
+
+        Image img = LoadImageFromTexture(target.texture);
+        //render textures are upside down
+        ImageFlipVertical(&img);
+        Allocator::free(target);
+        scratch.clear();
+        return img;
+    }
+
+    //hashes whatever submit adds, the order things get added in doesnt matter
+    u64 hash(const function<void()>& submit) {
+        record(scratch, submit);
+
+        auto hashInstance = [](const LightInstance& l, u64 h) {
+            const auto* bytes = reinterpret_cast<const u8*>(&l);
+            for (usize i = 0; i < sizeof(LightInstance); i++) {
+                h ^= bytes[i];
+                h *= 1099511628211ull;//fnv-1a
+            }
+            return h;
+        };
+
+        u64 ret = 0;
+        for (const auto& l: scratch.ambient) ret += hashInstance(l, 14695981039346656037ull);
+        //so an ambient quad and a light with the same numbers dont cancel out
+        for (const auto& l: scratch.lights) ret += hashInstance(l, 14695981039346656037ull ^ 0xff);
+        for (const auto& s: scratch.shadowed) {
+            u64 h = hashInstance(s.light, 14695981039346656037ull ^ 0xfe);
+            for (usize i = s.first; i < s.first + s.count; i++) {
+                const fvec2& p = scratch.polygon_points[i];
+                const LightInstance point = {p.x, p.y};
+                h = hashInstance(point, h);
+            }
+            ret += h;
+        }
+        scratch.clear();
+        return ret;
+    }
+
+    //what the last render() or bake() drew
+    [[nodiscard]] const LightingStats& lastStats() const {
+        return last_stats;
+    }
+
+    [[nodiscard]] const Texture2D& texture() const {
+        return light_buffer.texture;
+    }
+};
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef LIGHTMAP_HPP
+#define LIGHTMAP_HPP
+
+#include <filesystem>
+#include <fstream>
+#include "utils.hpp"
+#include "lighting.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+/*
+ * a level's static lighting (floors and lights that never change) baked into a texture, so it doesnt have to be
+ * redrawn every frame
+ * it's stored next to the level file as <level>.lightmap.png and <level>.lightmap.json, the json has the area the
+ * lightmap covers and a hash of the lighting it was baked from
+ * if the level's lighting doesnt match the hash anymore the lightmap is stale and doesnt get loaded
+ * the texture belongs to the lightmap alone, it stays out of the Allocator so it never shows up as art in the texture
+ * manager or counts towards (and gets evicted by) the texture budget
+ */
+class Lightmap {
+    Texture2D texture{};
+    bool loaded = false;
+    rect area{};
+    u64 hash = 0;
+
+    static string sidecar(const string& level_path, const char* extension) {
+        return filesystem::path(level_path).replace_extension(extension).generic_string();
+    }
+
+public:
+    static constexpr double texel_size = 4;//how many world units one pixel of the lightmap covers
+    static constexpr double max_size = 4096;//big levels get a coarser lightmap instead of a huge one
+
+    Lightmap() = default;
+
+    Lightmap(const Lightmap&) = delete;
+    Lightmap& operator =(const Lightmap&) = delete;
+
+    ~Lightmap() {
+        //the window (and the gl context with it) might already be gone when the level gets destroyed
+        if (IsWindowReady()) unload();
+    }
+
+    //loads the lightmap stored next to the level, returns false if there isnt one or it was baked from different lighting
+    bool load(const string& level_path, const u64 expected_hash) {
+        unload();
+        ifstream file(sidecar(level_path, ".lightmap.json"));
+        if (!file.is_open()) return false;
+
+        json data = json::parse(file, nullptr, false);
+        if (data.is_discarded()) return false;
+        if (!validateJsonData(data, "hash", json::value_t::number_unsigned)) return false;
+        if (!validateJsonData(data, "area", json::value_t::array)) return false;
+        if (data["hash"].get<u64>() != expected_hash) return false;
+
+        const auto v = data["area"].get<vector<double>>();
+        const string image = sidecar(level_path, ".lightmap.png");
+        if (v.size() != 4 || !filesystem::exists(image)) return false;
+
+        area = {v[0], v[1], v[2], v[3]};
+        hash = expected_hash;
+        texture = LoadTexture(image.data());
+        if (texture.id == 0) return false;
+        SetTextureFilter(texture, TEXTURE_FILTER_BILINEAR);
+        loaded = true;
+        return true;
+    }
+
+    /*
+     * bakes whatever submit adds (at the offset it's given) over the area and saves it next to the level
+     * has to be called outside of any texture mode
+     */
+    void bake(const string& level_path, const rect& bake_area, const u64 lighting_hash,
+              const function<void(dvec2)>& submit) {
+        unload();
+        const double texel = std::max(texel_size, std::max(bake_area.w, bake_area.h) / max_size);
+        Image img = LightingPass::instance().bake(bake_area, texel, [&] { submit(bake_area.pos()); });
+
+        const string image = sidecar(level_path, ".lightmap.png");
+        const bool exported = ExportImage(img, image.data());
+        if (!exported) {
+            UnloadImage(img);
+            throw Exception("Could not write lightmap ", image);
+        }
+
+        json data;
+        data["area"] = {bake_area.x, bake_area.y, bake_area.w, bake_area.h};
+        data["texel_size"] = texel;
+        data["hash"] = lighting_hash;
+        ofstream out(sidecar(level_path, ".lightmap.json"));
+        out << data.dump(4);
+
+        area = bake_area;
+        hash = lighting_hash;
+        //straight from the baked image, the png doesnt have to be read back
+        texture = LoadTextureFromImage(img);
+        UnloadImage(img);
+        SetTextureFilter(texture, TEXTURE_FILTER_BILINEAR);
+        loaded = true;
+    }
+
+    void unload() {
+        if (!loaded) return;
+        //the frame being drawn might still have it in its light list
+        LightingPass::instance().releaseAfterRender(texture);
+        loaded = false;
+    }
+
+    [[nodiscard]] bool valid() const {
+        return loaded;
+    }
+
+    //true if the lightmap is loaded and was baked from lighting with this hash
+    [[nodiscard]] bool matches(const u64 lighting_hash) const {
+        return loaded && hash == lighting_hash;
+    }
+
+    //hands the lightmap to the lighting pass, offset is the level's scroll
+    void submit(const dvec2 offset) const {
+        if (loaded) LightingPass::instance().addBaked(texture, area - offset);
+    }
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+/*
+ * a file mapped read only into memory, reading it is just reading memory and the os pages it in as it's touched
+ * the platform code lives in mapped_file.cpp, windows.h and raylib cant be included in the same file
+ */
+class MappedFile {
+    const std::byte* ptr = nullptr;
+    std::size_t length = 0;
+    void* file_handle = nullptr;//only used on windows
+    void* mapping_handle = nullptr;
+
+public:
+    MappedFile() = default;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator =(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator =(MappedFile&& other) noexcept;
+
+    ~MappedFile();
+
+    //maps the whole file, returns false if it doesnt exist, is empty or cant be mapped
+    bool open(const std::string& path);
+
+    void close();
+
+    [[nodiscard]] const std::byte* data() const {
+        return ptr;
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return length;
+    }
+
+    [[nodiscard]] bool isOpen() const {
+        return ptr != nullptr;
+    }
+};
+
+#endif
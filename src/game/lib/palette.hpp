@@ -0,0 +1,313 @@
+#ifndef PALETTE_HPP
+#define PALETTE_HPP
+
+#include <atomic>
+#include <rlgl.h>
+#include "utils.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+/*
+ * indexed color, every sprite sheet in resources gets turned into one byte per pixel (which color of the palette it
+ * is) when it's loaded, instead of four, and the colors get looked up from a shared palette texture while drawing
+ * the palette texture has one row per palette swap (the palette itself is row 0), so swapping the whole game's
+ * colors (a damage flash, night) is just picking another row
+ *
+ * slot 0 of every row is transparent, so one color of the palette has to give its slot up, it's whichever color is
+ * closest to another one and its pixels just use that one
+ * pixels that arent exactly a palette color get the closest one, like the palette post pass does
+ *
+ * raylib's default shader cant read indices, so anything that draws a texture that might be indexed has to call
+ * use() with it first, and release() once it's done drawing
+ * the editor never turns this on, its texture previews need the real colors
+ */
+class IndexedColor {
+    struct swap {
+        str name;
+        Color color;
+        float amount;//how far every color gets pulled towards color
+    };
+
+    bool enabled = false;
+    string palette_path;
+    array<Color, 256> colors{};
+    array<u8, 256> slot_of{};//palette index -> slot in the lut
+    vector<swap> swaps;
+    Texture2D lut{};
+    unordered_set<u32> indexed;//ids of every texture holding indices
+    atomic<usize> bytes_saved = 0;//images get indexed on the texture streamer's threads
+
+    Shader shader{};
+    i32 lut_loc = -1;
+    i32 row_loc = -1;
+    i32 cutoff_loc = -1;
+    i32 row = 0;
+    float alpha_cutoff = 0;
+    bool bound = false;
+    optional<Shader> base;//the shader that was on before use() switched to this one
+
+    logger LPalette = logger("palette");
+
+    IndexedColor() {
+        shader = Allocator::allocateShader(nullptr, "resources/shaders/indexed.fsh");
+        lut_loc = GetShaderLocation(shader, "palette");
+        row_loc = GetShaderLocation(shader, "paletteRow");
+        cutoff_loc = GetShaderLocation(shader, "alphaCutoff");
+    }
+
+    static u32 pack(const Color c) {
+        return cast(c.r, u32) << 16 | cast(c.g, u32) << 8 | c.b;
+    }
+
+    static i32 distance2(const Color a, const Color b) {
+        const i32 dr = a.r - b.r;
+        const i32 dg = a.g - b.g;
+        const i32 db = a.b - b.b;
+        return dr*dr + dg*dg + db*db;
+    }
+
+    //gives every palette color a slot, the one closest to another color shares that color's slot
+    void assignSlots() {
+        usize dropped = 0, replacement = 1;
+        i32 best = numeric_limits<i32>::max();
+        for (usize i = 0; i < colors.size(); i++) {
+            for (usize j = 0; j < colors.size(); j++) {
+                if (i == j) continue;
+                if (const i32 d = distance2(colors[i], colors[j]); d < best) {
+                    best = d;
+                    dropped = i;
+                    replacement = j;
+                }
+            }
+        }
+        u8 next = 1;
+        for (usize i = 0; i < colors.size(); i++) {
+            if (i != dropped) slot_of[i] = next++;
+        }
+        slot_of[dropped] = slot_of[replacement];
+    }
+
+    //nearest_cache is packed rgb -> slot, every image has its own so images can be indexed at the same time
+    u8 nearestSlot(const Color c, unordered_map<u32, u8>& nearest_cache) const {
+        const auto it = nearest_cache.find(pack(c));
+        if (it != nearest_cache.end()) return it->second;
+        usize best = 0;
+        for (usize i = 1; i < colors.size(); i++) {
+            if (distance2(c, colors[i]) < distance2(c, colors[best])) best = i;
+        }
+        return nearest_cache[pack(c)] = slot_of[best];
+    }
+
+    //row 0 is the palette, then one row for every swap
+    void buildLut() {
+        Image image = GenImageColor(256, cast(swaps.size() + 1, i32), BLANK);
+        for (usize i = 0; i < colors.size(); i++) {
+            const i32 slot = slot_of[i];
+            ImageDrawPixel(&image, slot, 0, colors[i]);
+            for (usize s = 0; s < swaps.size(); s++) {
+                ImageDrawPixel(&image, slot, cast(s + 1, i32), ColorLerp(colors[i], swaps[s].color, swaps[s].amount));
+            }
+        }
+        if (lut.id) UnloadTexture(lut);
+        lut = LoadTextureFromImage(image);
+        UnloadImage(image);
+    }
+
+    //turns the image into palette slots in place, one byte per pixel
+    void index(Image& image) {
+        unordered_map<u32, u8> nearest_cache;
+        ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        const usize count = cast(image.width, usize) * cast(image.height, usize);
+        const auto* pixels = cast(image.data, Color*);
+        auto* slots = cast(RL_MALLOC(count), u8*);
+        for (usize i = 0; i < count; i++) {
+            slots[i] = pixels[i].a < 128 ? 0 : nearestSlot(pixels[i], nearest_cache);
+        }
+        RL_FREE(image.data);
+        image.data = slots;
+        image.format = PIXELFORMAT_UNCOMPRESSED_GRAYSCALE;
+        image.mipmaps = 1;
+        bytes_saved += count * 3;
+    }
+
+    //only the art gets indexed, the palette itself keeps its colors
+    [[nodiscard]] bool shouldIndex(const str& path) const {
+        const string p = path.data();
+        return p != palette_path && p.starts_with("resources/");
+    }
+
+    //the lut goes on its own texture unit, raylib only uses the first few for its batches
+    void bindLut() const {
+        rlActiveTextureSlot(lut_unit);
+        rlEnableTexture(lut.id);
+        rlActiveTextureSlot(0);
+    }
+
+    void restore() const {
+        if (base) BeginShaderMode(*base);
+        else EndShaderMode();
+    }
+
+public:
+    static constexpr i32 lut_unit = 7;
+
+    IndexedColor(const IndexedColor&) = delete;
+    IndexedColor& operator =(const IndexedColor&) = delete;
+
+    static IndexedColor& instance() {
+        static IndexedColor p;
+        return p;
+    }
+
+    //the settings.json entry when it doesnt have one
+    static json defaultConfig() {
+        return {
+            {"enabled", false},
+            {"palette", "resources/pallette.png"},
+            {"swaps", json::array({
+                {{"name", "damage"}, {"color", {255, 255, 255}}, {"amount", 0.8}},
+                {{"name", "night"}, {"color", {20, 30, 90}}, {"amount", 0.55}},
+            })}
+        };
+    }
+
+    static bool validateConfig(const json& config) {
+        if (!validateJsonData(config, "enabled", json::value_t::boolean) ||
+            !validateJsonData(config, "palette", json::value_t::string) ||
+            !validateJsonData(config, "swaps", json::value_t::array)) return false;
+        return ranges::all_of(config["swaps"], [](const json& s) {
+            return s.is_object() &&
+                   validateJsonData(s, "name", json::value_t::string) &&
+                   validateJsonData(s, "color", json::value_t::array) && s["color"].size() == 3 &&
+                   validateJsonData(s, "amount", JSON_NUMBERS);
+        });
+    }
+
+    /*
+     * turns indexed color on or off, turning it on reloads every texture the Allocator has (and every animation with
+     * them), lightmaps arent in there and keep theirs
+     * returns whether the textures were reloaded
+     */
+    bool configure(const json& config) {
+        if (!config["enabled"].get<bool>()) {
+            enabled = false;
+            return false;
+        }
+        palette_path = config["palette"].get<string>();
+        Image palette = Allocator::loadImage(palette_path);
+        if (palette.width < 256 || palette.height < 1) {
+            LPalette.warn("Palette ", palette_path, " has to be at least 256x1, indexed color is off");
+            UnloadImage(palette);
+            enabled = false;
+            return false;
+        }
+        for (i32 i = 0; i < 256; i++) colors[i] = GetImageColor(palette, i, 0);
+        UnloadImage(palette);
+
+        swaps.clear();
+        for (const auto& s: config["swaps"]) {
+            const auto c = s["color"].get<array<u8, 3>>();
+            swaps.push_back({s["name"].get<string>(), Color{c[0], c[1], c[2], 255},
+                             std::clamp(s["amount"].get<float>(), 0.0f, 1.0f)});
+        }
+
+        assignSlots();
+        buildLut();
+        indexed.clear();
+        bytes_saved = 0;
+        row = 0;
+        enabled = true;
+
+        Allocator::setTextureLoader({
+            [this](const str& path, Image& image) { if (shouldIndex(path)) index(image); },
+            [this](const str& path, const Texture2D& texture) { if (shouldIndex(path)) indexed.insert(texture.id); },
+            [this](const str&, const Texture2D& texture) { indexed.erase(texture.id); }
+        });
+        //waits for every loaded texture
+        Allocator::reloadTextures(true, true);
+        LPalette.info("Indexed ", indexed.size(), " textures, saving ", bytes_saved / 1024, " KB");
+        return true;
+    }
+
+    [[nodiscard]] bool on() const {
+        return enabled;
+    }
+
+    [[nodiscard]] bool isIndexed(const Texture2D& texture) const {
+        return enabled && indexed.contains(texture.id);
+    }
+
+    //switches to (or away from) the palette shader depending on whether the texture about to be drawn is indexed
+    void use(const Texture2D& texture) {
+        if (!enabled) return;
+        const bool want = indexed.contains(texture.id);
+        if (want == bound) return;
+        bound = want;
+        if (!want) {
+            restore();
+            return;
+        }
+        BeginShaderMode(shader);
+        bindLut();
+        const i32 unit = lut_unit;
+        SetShaderValue(shader, lut_loc, &unit, SHADER_UNIFORM_INT);
+        SetShaderValue(shader, row_loc, &row, SHADER_UNIFORM_INT);
+        SetShaderValue(shader, cutoff_loc, &alpha_cutoff, SHADER_UNIFORM_FLOAT);
+    }
+
+    //goes back to whatever shader was on before use()
+    void release() {
+        if (!bound) return;
+        bound = false;
+        restore();
+    }
+
+    /*
+     * the shader to go back to when switching away from the palette shader (none is raylib's default), has to be set
+     * while nothing indexed is being drawn
+     */
+    void setBaseShader(const optional<Shader> shader_) {
+        release();
+        base = shader_;
+    }
+
+    //like DepthSorter's alpha test, applies from the next use()
+    void setAlphaCutoff(const float cutoff) {
+        alpha_cutoff = cutoff;
+    }
+
+    //picks the palette swap everything gets drawn with, an empty name (or one that doesnt exist) is the palette itself
+    void swapPalette(const str& name) {
+        i32 next = 0;
+        for (usize i = 0; i < swaps.size(); i++) {
+            if (swaps[i].name == name) next = cast(i + 1, i32);
+        }
+        if (next == row) return;
+        if (bound) {
+            //whatever was drawn so far was meant for the old palette
+            rlDrawRenderBatchActive();
+            SetShaderValue(shader, row_loc, &next, SHADER_UNIFORM_INT);
+        }
+        row = next;
+    }
+
+    //goes through every swap and then back to the palette itself
+    void nextSwap() {
+        swapPalette(cast(row, usize) < swaps.size() ? swaps[row].name : "");
+    }
+
+    [[nodiscard]] str currentSwap() const {
+        return row == 0 ? "none"_str : swaps[row - 1].name;
+    }
+
+    //for shaders that draw indexed textures themselves (like the animation batch), binds the lut and sets its uniforms
+    void bindFor(const i32 palette_loc, const i32 palette_row_loc) const {
+        bindLut();
+        const i32 unit = lut_unit;
+        rlSetUniform(palette_loc, &unit, RL_SHADER_UNIFORM_INT, 1);
+        rlSetUniform(palette_row_loc, &row, RL_SHADER_UNIFORM_INT, 1);
+    }
+};
+
+#endif
@@ -0,0 +1,386 @@
+#ifndef PARTICLES_HPP
+#define PARTICLES_HPP
+
+#include "JOB.hpp"
+#include "animation_batch.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+//how an emitter's particles move and change over their life, shared by every particle of the emitter
+struct ParticleSettings {
+    float gravity = 0;//pixels per second per second, down is positive
+    float drag = 0;//how much of its velocity a particle loses every second
+    float start_size = 4;
+    float end_size = 1;
+    Color start_color = WHITE;
+    Color end_color = {255, 255, 255, 0};
+};
+
+/*
+ * particles stored as one array per field instead of one struct per particle, so the update is a few flat loops over
+ * floats that the compiler turns into simd, and dead particles get swapped with the last one so the arrays never have
+ * holes
+ */
+class ParticlePool {
+    vector<float> x, y, vx, vy;
+    vector<float> age, life;
+    vector<float> born;//when it spawned on the animation batch's clock, so its animation starts from its first frame
+    vector<float> sizes;//size() is how many particles there are
+    vector<float> r, g, b, a;
+    usize count = 0;
+
+    //every array, for resizing all of them at once
+    [[nodiscard]] array<vector<float>*, 12> fields() {
+        return {&x, &y, &vx, &vy, &age, &life, &born, &sizes, &r, &g, &b, &a};
+    }
+
+public:
+    void reserve(const usize capacity) {
+        for (auto* f: fields()) f->resize(capacity);
+        count = std::min(count, capacity);
+    }
+
+    [[nodiscard]] usize capacity() const {
+        return x.size();
+    }
+
+    [[nodiscard]] usize size() const {
+        return count;
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+    //false if the pool is full
+    bool spawn(const float px, const float py, const float pvx, const float pvy, const float plife, const float pborn) {
+        if (count >= capacity()) return false;
+        x[count] = px;
+        y[count] = py;
+        vx[count] = pvx;
+        vy[count] = pvy;
+        age[count] = 0;
+        life[count] = std::max(plife, 0.001f);
+        born[count] = pborn;
+        count++;
+        return true;
+    }
+
+    /*
+     * the loops get their arrays as parameters since gcc only trusts __restrict on those, otherwise it checks every
+     * pair of arrays for overlap before the loop and gives up on vectorizing once there are more than a few pairs
+     */
+    static void advance(const usize n, const float delta, const float damping, const float fall, float* __restrict px,
+                     float* __restrict py, float* __restrict pvx, float* __restrict pvy) {
+        for (usize i = 0; i < n; i++) {
+            pvx[i] *= damping;
+            pvy[i] = pvy[i] * damping + fall;
+            px[i] += pvx[i] * delta;
+            py[i] += pvy[i] * delta;
+        }
+    }
+
+    static void grow(const usize n, const float delta, const ParticleSettings& s, float* __restrict page,
+                     const float* __restrict plife, float* __restrict psize, float* __restrict pr,
+                     float* __restrict pg, float* __restrict pb, float* __restrict pa) {
+        const float sr = s.start_color.r / 255.0f, dr = s.end_color.r / 255.0f - sr;
+        const float sg = s.start_color.g / 255.0f, dg = s.end_color.g / 255.0f - sg;
+        const float sb = s.start_color.b / 255.0f, db = s.end_color.b / 255.0f - sb;
+        const float sa = s.start_color.a / 255.0f, da = s.end_color.a / 255.0f - sa;
+        const float ss = s.start_size, ds = s.end_size - s.start_size;
+        for (usize i = 0; i < n; i++) {
+            page[i] += delta;
+            //past 1 means it's dead, update() takes it out before it's drawn, a min here would stop the vectorizing
+            const float t = page[i] / plife[i];
+            psize[i] = ss + ds * t;
+            pr[i] = sr + dr * t;
+            pg[i] = sg + dg * t;
+            pb[i] = sb + db * t;
+            pa[i] = sa + da * t;
+        }
+    }
+
+    void update(const float delta, const ParticleSettings& s) {
+        if (count == 0) return;
+        advance(count, delta, std::max(0.0f, 1.0f - s.drag * delta), s.gravity * delta,
+                x.data(), y.data(), vx.data(), vy.data());
+        //everything that changes over the particle's life
+        grow(count, delta, s, age.data(), life.data(), sizes.data(), r.data(), g.data(), b.data(), a.data());
+
+        //dead particles get replaced by the last one
+        for (usize i = 0; i < count;) {
+            if (age[i] < life[i]) {
+                i++;
+                continue;
+            }
+            count--;
+            for (auto* f: fields()) (*f)[i] = (*f)[count];
+        }
+    }
+
+    //adds every particle to the animation batch, stretched over its size and centered on its position
+    void submit(AnimationBatch& batch, animation& anim, const dvec2 offset) const {
+        if (count == 0) return;
+        AnimatedInstance* out = batch.reserve(anim, count);
+        const auto ox = cast(offset.x, float);
+        const auto oy = cast(offset.y, float);
+        for (usize i = 0; i < count; i++) {
+            AnimatedInstance& inst = out[i];
+            const float half = sizes[i] / 2;
+            inst.x = x[i] - half - ox;
+            inst.y = y[i] - half - oy;
+            inst.w = inst.h = sizes[i];
+            inst.start = born[i];
+            inst.stretch = 1;
+            inst.r = r[i];
+            inst.g = g[i];
+            inst.b = b[i];
+            inst.a = a[i];
+        }
+    }
+};
+
+
+/*
+ * spawns particles inside of its collision and draws all of them through the animation batch, so an emitter is one
+ * object in the level no matter how many particles it has, and every emitter using the same texture is one draw call
+ * particles only move while the level is updating, so they dont show up in the editor until the game is started
+ */
+struct ParticleEmitter : public LevelObject {
+GENERATE_LEVEL_OBJECT(ParticleEmitter)
+protected:
+    shared_ptr<animation> texture;
+    ParticleSettings settings;
+    float rate = 50;//particles per second
+    u32 max_particles = 1000;
+    float life = 1;//seconds
+    float life_variance = 0.25f;//how much of the life can be randomly taken off
+    float speed = 60;
+    float speed_variance = 0.5f;
+    float direction = -90;//degrees, 0 is right and -90 is up
+    float spread = 45;//degrees, the whole cone
+    bool emitting = true;
+
+    ParticlePool pool;
+    double spawn_debt = 0;//fractions of particles left over from the last update
+    u32 seed = 0x9E3779B9u;
+
+    //xorshift, 0 to 1
+    float random() {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return cast(seed >> 8, float) / cast(1u << 24, float);
+    }
+
+    void spawnOne() {
+        const float angle = (direction + (random() - 0.5f) * spread) * DEG2RAD;
+        const float v = speed * (1 - speed_variance * random());
+        pool.spawn(
+            cast(collision.x + collision.w * random(), float),
+            cast(collision.y + collision.h * random(), float),
+            std::cos(angle) * v, std::sin(angle) * v,
+            life * (1 - life_variance * random()),
+            cast(AnimationBatch::instance().time(), float));
+    }
+
+public:
+    ParticleEmitter() : LevelObject({0, 0, 16, 16}, collisionType::NO_COLLISION, true) {
+        texture = AnimationRegistry::Instance().get("default");
+    }
+
+    ParticleEmitter(const rect& area, shared_ptr<animation> anim, const ParticleSettings& s, const float rate,
+                    const u32 max_particles, const float life, const float life_variance, const float speed,
+                    const float speed_variance, const float direction, const float spread, const bool emitting) :
+    LevelObject(area, collisionType::NO_COLLISION, true), texture(std::move(anim)), settings(s), rate(rate),
+    max_particles(max_particles), life(life), life_variance(life_variance), speed(speed),
+    speed_variance(speed_variance), direction(direction), spread(spread), emitting(emitting) {
+        //emitters in different places shouldnt spawn in lockstep, xorshift also cant start at 0
+        seed = (seed ^ cast(std::hash<double>{}(area.x * 31 + area.y), u32)) | 1;
+    }
+
+    void update(const seconds_t delta) override {
+        if (pool.capacity() != max_particles) pool.reserve(max_particles);
+        if (emitting && rate > 0) {
+            spawn_debt += rate * delta;
+            //never more than the pool can hold, a long frame shouldnt pile up spawns
+            spawn_debt = std::min(spawn_debt, cast(max_particles, double));
+            for (; spawn_debt >= 1; spawn_debt--) spawnOne();
+        }
+        pool.update(cast(delta, float), settings);
+    }
+
+    [[nodiscard]] usize particleCount() const {
+        return pool.size();
+    }
+
+    //as far as a particle could possibly get from the spawn area
+    rect bounds() override {
+        const double t = std::max(life, 0.0f);
+        const double reach = speed * t + std::abs(settings.gravity) * t * t / 2 +
+                             std::max(settings.start_size, settings.end_size);
+        return collision | rect{collision.x - reach, collision.y - reach, collision.w + reach*2, collision.h + reach*2};
+    }
+
+    bool drawBatched(const dvec2 offset) override {
+        pool.submit(AnimationBatch::instance(), *texture, offset);
+        return true;
+    }
+
+    void draw(const dvec2 offset) override {
+        drawBatched(offset);
+    }
+
+    u32 batchKey() override {
+        return texture->getTexture().id;
+    }
+
+    str referencedAnimation() override {
+        return texture->getId();
+    }
+
+    bool isTranslucent() override {
+        return settings.start_color.a < 255 || settings.end_color.a < 255;
+    }
+
+    shared_ptr<LevelObject> copy(dvec2 pos) override {
+        return make_shared<ParticleEmitter>(collision.pure().pos(pos), texture, settings, rate, max_particles, life,
+                                            life_variance, speed, speed_variance, direction, spread, emitting);
+    }
+
+    pair<str, vector<ObjectParameter>> getParameters() override {
+        return {
+            "Particle Emitter",
+            {
+                ObjectParameter{"Spawn Area", OPType::RECT, &collision},
+                ObjectParameter{"Animation", OPType::ANIMATION, &texture},
+                ObjectParameter{"Emitting", OPType::BOOLEAN, &emitting},
+                ObjectParameter{"Rate", OPType::FLOAT32, &rate, 0, 10000},
+                ObjectParameter{"Max Particles", OPType::UNSIGNED_INTEGER32, &max_particles, 0, 100000},
+                ObjectParameter{"Life", OPType::FLOAT32, &life, 0.01, 30},
+                ObjectParameter{"Life Variance", OPType::FLOAT32, &life_variance, 0, 1},
+                ObjectParameter{"Speed", OPType::FLOAT32, &speed, 0, 1000},
+                ObjectParameter{"Speed Variance", OPType::FLOAT32, &speed_variance, 0, 1},
+                ObjectParameter{"Direction", OPType::FLOAT32, &direction, -180, 180},
+                ObjectParameter{"Spread", OPType::FLOAT32, &spread, 0, 360},
+                ObjectParameter{"Gravity", OPType::FLOAT32, &settings.gravity, -2000, 2000},
+                ObjectParameter{"Drag", OPType::FLOAT32, &settings.drag, 0, 10},
+                ObjectParameter{"Start Size", OPType::FLOAT32, &settings.start_size, 0.5, 128},
+                ObjectParameter{"End Size", OPType::FLOAT32, &settings.end_size, 0, 128},
+                ObjectParameter{"Start Color", OPType::COLOR, &settings.start_color},
+                ObjectParameter{"Start Alpha", OPType::UNSIGNED_INTEGER8, &settings.start_color.a, 0, 255},
+                ObjectParameter{"End Color", OPType::COLOR, &settings.end_color},
+                ObjectParameter{"End Alpha", OPType::UNSIGNED_INTEGER8, &settings.end_color.a, 0, 255},
+            }
+        };
+    }
+};
+
+struct ParticleEmitterFactory {
+    using factory_type = ParticleEmitter;
+
+    //the settings are flat in the json, so they're flat here too
+    struct fields {
+        rect area = {0, 0, 16, 16};
+        str texture = "default";
+        u32 max_particles = 1000;
+        bool emitting = true;
+        float rate = 50;
+        float life = 1;
+        float life_variance = 0.25f;
+        float speed = 60;
+        float speed_variance = 0.5f;
+        float direction = -90;
+        float spread = 45;
+        float gravity = ParticleSettings().gravity;
+        float drag = ParticleSettings().drag;
+        float start_size = ParticleSettings().start_size;
+        float end_size = ParticleSettings().end_size;
+        Color start_color = ParticleSettings().start_color;
+        Color end_color = ParticleSettings().end_color;
+    };
+
+    inline static const JsonSchema<fields> schema = JsonSchema<fields>()
+        .field("area", &fields::area)
+        .field("texture", &fields::texture)
+        .field("max_particles", &fields::max_particles)
+        .field("emitting", &fields::emitting)
+        .field("rate", &fields::rate, {0})
+        .field("life", &fields::life, {0})
+        .field("life_variance", &fields::life_variance)
+        .field("speed", &fields::speed)
+        .field("speed_variance", &fields::speed_variance)
+        .field("direction", &fields::direction)
+        .field("spread", &fields::spread)
+        .field("gravity", &fields::gravity)
+        .field("drag", &fields::drag)
+        .field("start_size", &fields::start_size)
+        .field("end_size", &fields::end_size)
+        .field("start_color", &fields::start_color)
+        .field("end_color", &fields::end_color);
+
+    NODISCARD static shared_ptr<factory_type> createFromJson(const json& data) {
+        const fields f = schema.read(data);
+        const ParticleSettings s = {f.gravity, f.drag, f.start_size, f.end_size, f.start_color, f.end_color};
+        return make_shared<factory_type>(f.area, AnimationRegistry::Instance().get(f.texture), s, f.rate,
+            std::min(f.max_particles, 100000u), f.life, f.life_variance, f.speed, f.speed_variance, f.direction,
+            f.spread, f.emitting);
+    }
+
+    NODISCARD static shared_ptr<factory_type> createDefault() {
+        return make_shared<factory_type>();
+    }
+
+    NODISCARD static json objectToJson(LevelObject& x) {
+        auto& obj = *dynamic_cast<ParticleEmitter*>(&x);
+        const ParticleSettings& s = obj.settings;
+        json res;
+        res["area"] = obj.collision.components();
+        res["texture"] = obj.texture->getId();
+        res["emitting"] = obj.emitting;
+        res["rate"] = obj.rate;
+        res["max_particles"] = obj.max_particles;
+        res["life"] = obj.life;
+        res["life_variance"] = obj.life_variance;
+        res["speed"] = obj.speed;
+        res["speed_variance"] = obj.speed_variance;
+        res["direction"] = obj.direction;
+        res["spread"] = obj.spread;
+        res["gravity"] = s.gravity;
+        res["drag"] = s.drag;
+        res["start_size"] = s.start_size;
+        res["end_size"] = s.end_size;
+        res["start_color"] = {s.start_color.r, s.start_color.g, s.start_color.b, s.start_color.a};
+        res["end_color"] = {s.end_color.r, s.end_color.g, s.end_color.b, s.end_color.a};
+        return res;
+    }
+
+    struct record {
+        BinaryRect area;
+        BinaryString texture;
+        ParticleSettings settings;
+        float rate, life, life_variance, speed, speed_variance, direction, spread;
+        u32 max_particles;
+        bool emitting;
+        array<u8, 7> unused{};//the padding, spelled out so it's saved as zeros
+    };
+    static_assert(sizeof(record) == 104);
+
+    NODISCARD static shared_ptr<factory_type> createFromBinary(const record& r, const BinaryLevelFile& file) {
+        return make_shared<factory_type>(r.area.toRect(), AnimationRegistry::Instance().get(string(file.text(r.texture))),
+            r.settings, r.rate, std::min(r.max_particles, 100000u), r.life, r.life_variance, r.speed, r.speed_variance,
+            r.direction, r.spread, r.emitting);
+    }
+
+    NODISCARD static record objectToBinary(LevelObject& x, BinaryLevelWriter& out) {
+        auto& obj = *dynamic_cast<ParticleEmitter*>(&x);
+        return {BinaryRect::of(obj.collision), out.addString(obj.texture->getId().stdStr()), obj.settings, obj.rate,
+                obj.life, obj.life_variance, obj.speed, obj.speed_variance, obj.direction, obj.spread,
+                obj.max_particles, obj.emitting};
+    }
+};
+
+REGISTER(ParticleEmitter, "particle_emitter")
+
+#endif
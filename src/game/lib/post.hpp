@@ -0,0 +1,262 @@
+#ifndef POST_HPP
+#define POST_HPP
+
+#include "globals.hpp"
+#include "utils.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+/*
+ * remembers where a shader's uniforms are and what they were last set to, so looking them up and re-uploading
+ * values that didnt change doesnt happen every frame
+ */
+class UniformCache {
+    struct entry {
+        i32 location = -1;
+        vector<float> value;
+    };
+
+    Shader shader{};
+    unordered_map<str, entry> entries;
+
+    entry& get(const str& name) {
+        auto it = entries.find(name);
+        if (it == entries.end()) {
+            it = entries.emplace(name, entry{GetShaderLocation(shader, name.data()), {}}).first;
+        }
+        return it->second;
+    }
+
+public:
+    UniformCache() = default;
+
+    explicit UniformCache(const Shader& s) : shader(s) {}
+
+    [[nodiscard]] i32 location(const str& name) {
+        return get(name).location;
+    }
+
+    //sets a float or vec2-vec4 uniform, only uploads it if it changed
+    void set(const str& name, const vector<float>& value) {
+        entry& e = get(name);
+        if (e.location == -1 || value.empty() || value.size() > 4 || e.value == value) return;
+        e.value = value;
+        constexpr i32 types[] = {SHADER_UNIFORM_FLOAT, SHADER_UNIFORM_VEC2, SHADER_UNIFORM_VEC3, SHADER_UNIFORM_VEC4};
+        SetShaderValue(shader, e.location, value.data(), types[value.size() - 1]);
+    }
+
+    //samplers have to be set every time the shader is used
+    void setTexture(const str& name, const Texture2D& texture) {
+        const i32 loc = location(name);
+        if (loc != -1) SetShaderValueTexture(shader, loc, texture);
+    }
+};
+
+
+/*
+ * the post processing applied to the scene before it's put on the screen, shared by the game and the editor
+ * it's a chain of fragment shader passes read from settings.json, every pass reads what the pass before it drew
+ * passes are drawn into ping-pong render textures that are shared between every pass with the same size, so the
+ * whole chain only ever needs two buffers per size, sizes that no pass drew at in a frame get freed at the end of it
+ * a pass can be drawn at a fraction of the scene's resolution (scale), disabled passes are skipped entirely
+ *
+ * a pass in settings.json looks like:
+ *  {
+ *      "name": "bloom",
+ *      "shader": "resources/shaders/bloom.fsh",
+ *      "enabled": true,
+ *      "scale": 1.0,
+ *      "uniforms": {"threshold": 0.7},                      floats or arrays of 2-4 floats
+ *      "textures": {"palette": "resources/pallette.png"},   image files
+ *      "inputs": ["lightmap"]                               textures the game hands in with setInput()
+ *  }
+ * every pass also gets texture0 (the pass before it), resolution (its own size) and time
+ */
+class PostChain {
+public:
+    struct pass {
+        str name;
+        Shader shader{};
+        bool enabled = true;
+        float scale = 1;
+
+        UniformCache uniforms;
+        vector<pair<str, vector<float>>> values;
+        vector<pair<str, Texture2D>> textures;
+        vector<str> inputs;
+    };
+
+private:
+    struct buffer {
+        array<RenderTexture2D, 2> textures{};
+        bool used = false;//drawn into this frame
+    };
+
+    vector<pass> passes;
+    unordered_map<str, Texture2D> inputs;
+    unordered_map<i64, buffer> buffers;
+    logger LPost = logger("post-chain");
+
+    PostChain() = default;
+
+    static i64 key(const i32 w, const i32 h) {
+        return (cast(w, i64) << 32) | cast(cast(h, u32), i64);
+    }
+
+    //a buffer of the size that isnt the one being read from
+    const RenderTexture2D& target(const i32 w, const i32 h, const Texture2D& scene, const Texture2D& reading) {
+        auto it = buffers.find(key(w, h));
+        if (it == buffers.end()) {
+            buffer pair;
+            for (auto& b: pair.textures) {
+                b = Allocator::allocateRenderTexture(w, h);
+                //anything drawn smaller than the scene gets smoothed when it's scaled back up
+                if (w < scene.width) SetTextureFilter(b.texture, TEXTURE_FILTER_BILINEAR);
+            }
+            it = buffers.emplace(key(w, h), pair).first;
+        }
+        auto& textures = it->second.textures;
+        it->second.used = true;
+        return textures[0].texture.id == reading.id ? textures[1] : textures[0];
+    }
+
+    //the scene changed size (dynamic resolution) or a pass got turned off or rescaled, so nothing reads these anymore
+    void freeUnused() {
+        for (auto it = buffers.begin(); it != buffers.end();) {
+            if (it->second.used) {
+                it->second.used = false;
+                ++it;
+                continue;
+            }
+            for (const auto& b: it->second.textures) Allocator::free(b);
+            it = buffers.erase(it);
+        }
+    }
+
+    void unload() {
+        //the textures belong to the allocator's cache, something else might be using them
+        for (const auto& p: passes) Allocator::free(p.shader);
+        passes.clear();
+    }
+
+public:
+    PostChain(const PostChain&) = delete;
+    PostChain& operator =(const PostChain&) = delete;
+
+    static PostChain& instance() {
+        static PostChain chain;
+        return chain;
+    }
+
+    //the chain settings.json gets when it doesnt have one
+    static json defaultConfig() {
+        json chain = json::array();
+        chain.push_back({
+            {"name", "uv_replace"}, {"shader", "resources/shaders/uv_replace.fsh"}, {"enabled", true}, {"scale", 1.0},
+            {"uniforms", {{"uvColor", {UV_COLOR.r/255.0, UV_COLOR.g/255.0, UV_COLOR.b/255.0}}}}
+        });
+        chain.push_back({
+            {"name", "lighting"}, {"shader", "resources/shaders/lighting.fsh"}, {"enabled", true}, {"scale", 1.0},
+            {"inputs", {"lightmap"}}
+        });
+        chain.push_back({
+            {"name", "palette"}, {"shader", "resources/shaders/palette.fsh"}, {"enabled", false}, {"scale", 1.0},
+            {"uniforms", {{"strength", 1.0}}}, {"textures", {{"palette", "resources/pallette.png"}}}
+        });
+        chain.push_back({
+            {"name", "bloom"}, {"shader", "resources/shaders/bloom.fsh"}, {"enabled", false}, {"scale", 1.0},
+            {"uniforms", {{"threshold", 0.75}, {"intensity", 0.6}, {"radius", 2.0}}}
+        });
+        chain.push_back({
+            {"name", "vignette"}, {"shader", "resources/shaders/vignette.fsh"}, {"enabled", false}, {"scale", 1.0},
+            {"uniforms", {{"strength", 0.35}, {"size", 0.6}}}
+        });
+        return chain;
+    }
+
+    //true if the json is a chain configure() can use
+    static bool validateConfig(const json& chain) {
+        if (!chain.is_array()) return false;
+        return ranges::all_of(chain, [](const json& p) {
+            return validateJsonData(p, "name", json::value_t::string) &&
+                   validateJsonData(p, "shader", json::value_t::string);
+        });
+    }
+
+    //throws away the current passes and loads the ones described by the json, has to be called after the window is made
+    void configure(const json& chain) {
+        unload();
+        for (const auto& p: chain) {
+            pass ps;
+            ps.name = p["name"].get<string>();
+            ps.shader = Allocator::allocateShader(nullptr, p["shader"].get<string>().data());
+            ps.uniforms = UniformCache(ps.shader);
+            if (validateJsonData(p, "enabled", json::value_t::boolean)) ps.enabled = p["enabled"].get<bool>();
+            if (validateJsonData(p, "scale", JSON_NUMBERS)) ps.scale = std::clamp(p["scale"].get<float>(), 0.05f, 1.0f);
+
+            if (validateJsonData(p, "uniforms", json::value_t::object)) {
+                for (const auto& [name, value]: p["uniforms"].items()) {
+                    if (value.is_number()) ps.values.emplace_back(name, vector{value.get<float>()});
+                    else if (value.is_array()) ps.values.emplace_back(name, value.get<vector<float>>());
+                }
+            }
+            if (validateJsonData(p, "textures", json::value_t::object)) {
+                for (const auto& [name, file]: p["textures"].items()) {
+                    ps.textures.emplace_back(name, Allocator::allocateTexture(file.get<string>().data()));
+                }
+            }
+            if (validateJsonData(p, "inputs", json::value_t::array)) {
+                for (const auto& name: p["inputs"]) ps.inputs.emplace_back(name.get<string>());
+            }
+
+            LPost.info("Loaded pass [", ps.name, "]", ps.enabled ? "" : " (disabled)");
+            passes.push_back(std::move(ps));
+        }
+    }
+
+    //a texture the game makes every frame that passes can ask for by name (like the light buffer)
+    void setInput(const str& name, const Texture2D& texture) {
+        inputs[name] = texture;
+    }
+
+    vector<pass>& getPasses() {
+        return passes;
+    }
+
+    /*
+     * runs every enabled pass over the scene and returns what the last one drew, or the scene if none of them are
+     * enabled, the result is upside down like every render texture
+     * has to be called outside of any texture mode
+     */
+    const Texture2D& apply(const Texture2D& scene) {
+        const Texture2D* current = &scene;
+        const auto time = cast(GetTime(), float);
+
+        for (auto& p: passes) {
+            if (!p.enabled) continue;
+            const i32 w = std::max(1, cast(scene.width * p.scale, i32));
+            const i32 h = std::max(1, cast(scene.height * p.scale, i32));
+            const RenderTexture2D& out = target(w, h, scene, *current);
+
+            BeginTextureMode(out);
+            BeginShaderMode(p.shader);
+            p.uniforms.set("resolution", {cast(w, float), cast(h, float)});
+            p.uniforms.set("time", {time});
+            for (const auto& [name, value]: p.values) p.uniforms.set(name, value);
+            for (const auto& [name, texture]: p.textures) p.uniforms.setTexture(name, texture);
+            for (const auto& name: p.inputs) {
+                if (const auto it = inputs.find(name); it != inputs.end()) p.uniforms.setTexture(name, it->second);
+            }
+            DrawTexturePro(*current, rect{0, 0, current->width, -current->height}, rect{0, 0, w, h}, {0, 0}, 0, WHITE);
+            EndShaderMode();
+            EndTextureMode();
+
+            current = &out.texture;
+        }
+        freeUnused();
+        return *current;
+    }
+};
+
+#endif
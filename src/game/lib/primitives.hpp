@@ -0,0 +1,220 @@
+#ifndef PRIMITIVES_HPP
+#define PRIMITIVES_HPP
+
+#include <bit>
+#include <raymath.h>
+#include <rlgl.h>
+#include "utils.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+/*
+ * collects flat colored shapes (ellipses, circles, lines, rect outlines) as triangles and draws all of them with a
+ * single draw call when it's flushed, instead of a raylib draw call and a batch check for every shape
+ * shapes that never change (like the collision of static objects) can be kept around under a key with
+ * beginPersistent(), they're only uploaded again when one of them changes and are drawn with one more draw call
+ * there's one batch for drop shadows and one for debug shapes, since they get drawn at different times
+ */
+class PrimitiveBatch {
+    struct vertex {
+        float x, y;
+        u8 r, g, b, a;
+    };
+
+    struct gpu_buffer {
+        u32 vao = 0;
+        u32 vbo = 0;
+        usize capacity = 0;
+
+        //makes sure the buffer fits count vertices and uploads them
+        void upload(const vector<vertex>& vertices) {
+            if (vertices.size() > capacity) {
+                if (!vao) vao = rlLoadVertexArray();
+                rlEnableVertexArray(vao);
+                if (vbo) rlUnloadVertexBuffer(vbo);
+                capacity = std::bit_ceil(std::max<usize>(vertices.size(), 1024));
+                vbo = rlLoadVertexBuffer(nullptr, cast(capacity * sizeof(vertex), i32), true);
+                rlSetVertexAttribute(0, 2, RL_FLOAT, false, sizeof(vertex), offsetof(vertex, x));
+                rlEnableVertexAttribute(0);
+                rlSetVertexAttribute(1, 4, RL_UNSIGNED_BYTE, true, sizeof(vertex), offsetof(vertex, r));
+                rlEnableVertexAttribute(1);
+                rlDisableVertexArray();
+            }
+            rlUpdateVertexBuffer(vbo, vertices.data(), cast(vertices.size() * sizeof(vertex), i32), 0);
+        }
+
+        void draw(const usize count) const {
+            rlEnableVertexArray(vao);
+            rlDrawVertexArray(0, cast(count, i32));
+            rlDisableVertexArray();
+        }
+    };
+
+    Shader shader{};
+    i32 mvp_loc = -1;
+
+    vector<vertex> frame;//cleared every flush
+    unordered_map<u64, vector<vertex>> persistent;
+    vector<vertex> persistent_flat;//every persistent shape one after another, what's actually on the gpu
+    bool persistent_dirty = false;
+    vector<vertex>* target = &frame;
+
+    gpu_buffer frame_buffer;
+    gpu_buffer persistent_buffer;
+
+    PrimitiveBatch() {
+        shader = Allocator::allocateShader("resources/shaders/primitives.vsh", "resources/shaders/primitives.fsh");
+        mvp_loc = GetShaderLocation(shader, "mvp");
+    }
+
+    void vertex2(const dvec2 p, const Color c) const {
+        target->push_back({cast(p.x, float), cast(p.y, float), c.r, c.g, c.b, c.a});
+    }
+
+    //how many sides a round shape this big needs before it looks round
+    static i32 segmentsFor(const double radius) {
+        return std::clamp(cast(std::ceil(radius / 2), i32) * 4, 12, 64);
+    }
+
+    static void setMvp(const i32 loc, const dvec2 translation) {
+        rlPushMatrix();
+        rlTranslatef(cast(translation.x, float), cast(translation.y, float), 0);
+        const Matrix mvp = MatrixMultiply(MatrixMultiply(rlGetMatrixTransform(), rlGetMatrixModelview()),
+                                          rlGetMatrixProjection());
+        rlPopMatrix();
+        rlSetUniformMatrix(loc, mvp);
+    }
+
+public:
+    PrimitiveBatch(const PrimitiveBatch&) = delete;
+    PrimitiveBatch& operator =(const PrimitiveBatch&) = delete;
+
+    //drop shadows, drawn by the level under every object
+    static PrimitiveBatch& shadows() {
+        static PrimitiveBatch batch;
+        return batch;
+    }
+
+    //collision boxes and anything else debug mode draws
+    static PrimitiveBatch& debug() {
+        static PrimitiveBatch batch;
+        return batch;
+    }
+
+    /*
+     * everything added until endPersistent() gets kept under the key (replacing whatever was there) and drawn on
+     * every flush until it's forgotten
+     */
+    void beginPersistent(const u64 key) {
+        target = &persistent[key];
+        target->clear();
+        persistent_dirty = true;
+    }
+
+    void endPersistent() {
+        target = &frame;
+    }
+
+    [[nodiscard]] bool hasPersistent(const u64 key) const {
+        return persistent.contains(key);
+    }
+
+    void forget(const u64 key) {
+        if (persistent.erase(key)) persistent_dirty = true;
+    }
+
+    void clearPersistent() {
+        if (persistent.empty()) return;
+        persistent.clear();
+        persistent_dirty = true;
+    }
+
+    void triangle(const dvec2 a, const dvec2 b, const dvec2 c, const Color color) {
+        vertex2(a, color);
+        vertex2(b, color);
+        vertex2(c, color);
+    }
+
+    void rectangle(const rect& r, const Color color) {
+        const dvec2 tl = {r.x, r.y};
+        const dvec2 tr = {r.x + r.w, r.y};
+        const dvec2 br = {r.x + r.w, r.y + r.h};
+        const dvec2 bl = {r.x, r.y + r.h};
+        triangle(tl, bl, br, color);
+        triangle(tl, br, tr, color);
+    }
+
+    //the outline is drawn inside of the rect like DrawRectangleLinesEx
+    void rectangleLines(const rect& r, const double thickness, const Color color) {
+        const double t = std::min({thickness, r.w / 2, r.h / 2});
+        rectangle({r.x, r.y, r.w, t}, color);
+        rectangle({r.x, r.y + r.h - t, r.w, t}, color);
+        rectangle({r.x, r.y + t, t, r.h - t*2}, color);
+        rectangle({r.x + r.w - t, r.y + t, t, r.h - t*2}, color);
+    }
+
+    void line(const dvec2 a, const dvec2 b, const double thickness, const Color color) {
+        const double dx = b.x - a.x;
+        const double dy = b.y - a.y;
+        const double len = std::sqrt(dx*dx + dy*dy);
+        if (len == 0) return;
+        const dvec2 n = {-dy / len * thickness / 2, dx / len * thickness / 2};
+        const dvec2 a1 = {a.x + n.x, a.y + n.y};
+        const dvec2 a2 = {a.x - n.x, a.y - n.y};
+        const dvec2 b1 = {b.x + n.x, b.y + n.y};
+        const dvec2 b2 = {b.x - n.x, b.y - n.y};
+        triangle(a1, a2, b2, color);
+        triangle(a1, b2, b1, color);
+    }
+
+    void ellipse(const dvec2 center, const double rx, const double ry, const Color color) {
+        const i32 segments = segmentsFor(std::max(rx, ry));
+        dvec2 last = {center.x + rx, center.y};
+        for (i32 i = 1; i <= segments; i++) {
+            const double a = 2 * PI * i / segments;
+            const dvec2 next = {center.x + std::cos(a) * rx, center.y + std::sin(a) * ry};
+            triangle(center, last, next, color);
+            last = next;
+        }
+    }
+
+    void circle(const dvec2 center, const double radius, const Color color) {
+        ellipse(center, radius, radius, color);
+    }
+
+    /*
+     * draws the persistent shapes (moved by offset, they're usually in world space) and then everything added since
+     * the last flush, with whatever transform is active
+     */
+    void flush(const dvec2 persistent_offset = {0, 0}) {
+        target = &frame;
+        if (persistent_dirty) {
+            persistent_flat.clear();
+            for (const auto& v: persistent | views::values) persistent_flat.insert(persistent_flat.end(), v.begin(), v.end());
+            if (!persistent_flat.empty()) persistent_buffer.upload(persistent_flat);
+            persistent_dirty = false;
+        }
+        if (persistent_flat.empty() && frame.empty()) return;
+
+        //anything raylib has batched was drawn first, so it has to get to the gpu first too
+        rlDrawRenderBatchActive();
+        //shapes get added in whatever winding, so none of them should get culled
+        rlDisableBackfaceCulling();
+        rlEnableShader(shader.id);
+        if (!persistent_flat.empty()) {
+            setMvp(mvp_loc, {-persistent_offset.x, -persistent_offset.y});
+            persistent_buffer.draw(persistent_flat.size());
+        }
+        if (!frame.empty()) {
+            frame_buffer.upload(frame);
+            setMvp(mvp_loc, {0, 0});
+            frame_buffer.draw(frame.size());
+            frame.clear();
+        }
+        rlDisableShader();
+        rlEnableBackfaceCulling();
+    }
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef SHADOWS_HPP
+#define SHADOWS_HPP
+
+#include "utils.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+//one edge of something lights cant go through, in world space
+struct Occluder {
+    dvec2 a;
+    dvec2 b;
+    usize visit_stamp = 0;//so spatial queries only hand back a segment once
+};
+
+//the 4 edges of a rect, in order around it
+inline array<Occluder, 4> occludersFromRect(const rect& r) {
+    const dvec2 tl = {r.x, r.y};
+    const dvec2 tr = {r.x + r.w, r.y};
+    const dvec2 br = {r.x + r.w, r.y + r.h};
+    const dvec2 bl = {r.x, r.y + r.h};
+    return {Occluder{tl, tr}, Occluder{tr, br}, Occluder{br, bl}, Occluder{bl, tl}};
+}
+
+/*
+ * builds the area a light at center can see out to radius, as a polygon around the center (a triangle fan)
+ * works by casting a ray at (and just past) every segment end and keeping the closest hit, so it's
+ * O(segments^2) and should only be given the segments near the light
+ */
+inline void buildVisibilityPolygon(const dvec2 center, const double radius, const vector<const Occluder*>& occluders,
+                                   vector<dvec2>& out) {
+    struct segment {
+        double ax, ay, bx, by;
+    };
+    //everything relative to the center from here on
+    vector<segment> segments;
+    segments.reserve(occluders.size() + 4);
+    for (const auto* o: occluders) {
+        segments.push_back({o->a.x - center.x, o->a.y - center.y, o->b.x - center.x, o->b.y - center.y});
+    }
+    //the edge of the light, so every ray hits something
+    const double r = radius;
+    segments.push_back({-r, -r, r, -r});
+    segments.push_back({r, -r, r, r});
+    segments.push_back({r, r, -r, r});
+    segments.push_back({-r, r, -r, -r});
+
+    vector<double> angles;
+    angles.reserve(segments.size() * 6);
+    constexpr double epsilon = 0.0001;
+    for (const auto& s: segments) {
+        for (const double a: {std::atan2(s.ay, s.ax), std::atan2(s.by, s.bx)}) {
+            angles.push_back(a - epsilon);
+            angles.push_back(a);
+            angles.push_back(a + epsilon);
+        }
+    }
+    ranges::sort(angles);
+
+    out.clear();
+    out.reserve(angles.size());
+    for (const double a: angles) {
+        const double dx = std::cos(a);
+        const double dy = std::sin(a);
+        double closest = 1.0/0.0;
+        for (const auto& s: segments) {
+            const double sx = s.bx - s.ax;
+            const double sy = s.by - s.ay;
+            const double denom = dx * sy - dy * sx;
+            if (std::abs(denom) < 1e-12) continue;//parallel
+            const double t = (s.ax * sy - s.ay * sx) / denom;//along the ray
+            const double u = (s.ax * dy - s.ay * dx) / denom;//along the segment
+            if (t >= 0 && u >= 0 && u <= 1 && t < closest) closest = t;
+        }
+        if (std::isinf(closest)) continue;
+        out.push_back({center.x + dx * closest, center.y + dy * closest});
+    }
+}
+
+#endif
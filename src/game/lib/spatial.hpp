@@ -0,0 +1,106 @@
+#ifndef SPATIAL_HPP
+#define SPATIAL_HPP
+
+#include "utils.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+/*
+ * a uniform grid over the level for finding everything inside of an area without looking at every object
+ * an item is put in every cell its bounds touch, so queries can hand back the same item more than once
+ * the grid only stores pointers, whoever inserts an item has to remove it (with the same bounds) before it dies
+ */
+template<typename T>
+class SpatialGrid {
+public:
+    static constexpr double cell_size = 128;
+
+private:
+    struct cell_range {
+        i32 x1, y1, x2, y2;
+
+        bool operator ==(const cell_range& r) const {
+            return x1 == r.x1 && y1 == r.y1 && x2 == r.x2 && y2 == r.y2;
+        }
+    };
+
+    unordered_map<i64, vector<T*>> cells;
+
+    static i64 key(const i32 cx, const i32 cy) {
+        return (cast(cx, i64) << 32) | cast(cast(cy, u32), i64);
+    }
+
+    static i32 toCell(const double v) {
+        return cast(std::floor(v / cell_size), i32);
+    }
+
+    static cell_range range(const rect& r) {
+        return {toCell(r.x), toCell(r.y), toCell(r.x + r.w), toCell(r.y + r.h)};
+    }
+
+    void insert(T* item, const cell_range& r) {
+        for (i32 cy = r.y1; cy <= r.y2; cy++) {
+            for (i32 cx = r.x1; cx <= r.x2; cx++) {
+                cells[key(cx, cy)].push_back(item);
+            }
+        }
+    }
+
+    void remove(T* item, const cell_range& r) {
+        for (i32 cy = r.y1; cy <= r.y2; cy++) {
+            for (i32 cx = r.x1; cx <= r.x2; cx++) {
+                const auto it = cells.find(key(cx, cy));
+                if (it == cells.end()) continue;
+
+                auto& items = it->second;
+                const auto found = ranges::find(items, item);
+                if (found == items.end()) continue;
+                //order in a cell doesnt matter so just swap it with the back
+                *found = items.back();
+                items.pop_back();
+                if (items.empty()) cells.erase(it);
+            }
+        }
+    }
+
+public:
+
+    void insert(T* item, const rect& bounds) {
+        insert(item, range(bounds));
+    }
+
+    void remove(T* item, const rect& bounds) {
+        remove(item, range(bounds));
+    }
+
+    //moves an item from one set of bounds to another, does nothing if it stays in the same cells
+    void move(T* item, const rect& old_bounds, const rect& new_bounds) {
+        const cell_range from = range(old_bounds);
+        const cell_range to = range(new_bounds);
+        if (from == to) return;
+        remove(item, from);
+        insert(item, to);
+    }
+
+    //calls f on every item in the cells touching the area, items can show up more than once and might not actually touch the area
+    template<typename F>
+    void query(const rect& area, F&& f) const {
+        const cell_range r = range(area);
+        for (i32 cy = r.y1; cy <= r.y2; cy++) {
+            for (i32 cx = r.x1; cx <= r.x2; cx++) {
+                const auto it = cells.find(key(cx, cy));
+                if (it == cells.end()) continue;
+                for (T* item: it->second) {
+                    f(item);
+                }
+            }
+        }
+    }
+
+    void clear() {
+        cells.clear();
+    }
+};
+
+#endif
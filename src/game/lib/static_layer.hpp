@@ -0,0 +1,121 @@
+#ifndef STATIC_LAYER_HPP
+#define STATIC_LAYER_HPP
+
+#include "globals.hpp"
+#include "utils.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+/*
+ * caches everything in a level that never changes at runtime (floors, flat props, etc.) into world-space
+ * render texture chunks, so instead of redrawing every one of those objects each frame we just blit the chunks
+ * that are on screen
+ * a chunk is only redrawn when something inside of it gets invalidated (usually by the editor)
+ */
+class StaticLayerCache {
+public:
+    static constexpr i32 chunk_size = 512;
+
+private:
+    struct chunk {
+        i32 cx = 0;
+        i32 cy = 0;
+        RenderTexture2D texture{};
+        bool allocated = false;//empty chunks dont get a texture
+        bool dirty = true;
+    };
+
+    unordered_map<i64, chunk> chunks;
+
+    static i64 key(const i32 cx, const i32 cy) {
+        return (cast(cx, i64) << 32) | cast(cast(cy, u32), i64);
+    }
+
+    static i32 toChunk(const double v) {
+        return cast(std::floor(v / chunk_size), i32);
+    }
+
+    static rect chunkArea(const chunk& c) {
+        return {c.cx * chunk_size, c.cy * chunk_size, chunk_size, chunk_size};
+    }
+
+public:
+
+    StaticLayerCache() = default;
+
+    StaticLayerCache(const StaticLayerCache&) = delete;
+    StaticLayerCache& operator =(const StaticLayerCache&) = delete;
+
+    ~StaticLayerCache() {
+        //the window (and the gl context with it) might already be gone when the level gets destroyed
+        if (IsWindowReady()) clear();
+    }
+
+    //marks every chunk touching the area as needing a redraw
+    void invalidate(const rect& area) {
+        for (i32 cy = toChunk(area.y); cy <= toChunk(area.y + area.h); cy++) {
+            for (i32 cx = toChunk(area.x); cx <= toChunk(area.x + area.w); cx++) {
+                chunk& c = chunks[key(cx, cy)];
+                c.cx = cx;
+                c.cy = cy;
+                c.dirty = true;
+            }
+        }
+    }
+
+    //frees every chunk, anything that should still be cached has to be invalidated again afterward
+    void clear() {
+        for (auto& c: chunks | views::values) {
+            if (c.allocated) Allocator::free(c.texture);
+        }
+        chunks.clear();
+    }
+
+    /*
+     * redraws every dirty chunk, has to be called outside of any texture mode
+     * has_content: returns true if there is anything static inside of the area
+     * draw_area: draws everything static inside of the area, the area's position is the offset to draw with
+     */
+    void rebuild(const function<bool(const rect&)>& has_content, const function<void(const rect&)>& draw_area) {
+        for (auto& c: chunks | views::values) {
+            if (!c.dirty) continue;
+            c.dirty = false;
+
+            const rect area = chunkArea(c);
+            if (!has_content(area)) {
+                if (c.allocated) {
+                    Allocator::free(c.texture);
+                    c.allocated = false;
+                }
+                continue;
+            }
+
+            if (!c.allocated) {
+                c.texture = Allocator::allocateRenderTexture(chunk_size, chunk_size);
+                c.allocated = true;
+            }
+
+            BeginTextureMode(c.texture);
+            ClearBackground(BLANK);
+            draw_area(area);
+            EndTextureMode();
+        }
+    }
+
+    //blits every cached chunk that overlaps the view
+    void draw(const rect& view, const dvec2 offset) {
+        for (i32 cy = toChunk(view.y); cy <= toChunk(view.y + view.h); cy++) {
+            for (i32 cx = toChunk(view.x); cx <= toChunk(view.x + view.w); cx++) {
+                const auto it = chunks.find(key(cx, cy));
+                if (it == chunks.end() || !it->second.allocated) continue;
+
+                DrawTexturePro(it->second.texture.texture,
+                               rect{0, 0, chunk_size, -chunk_size},
+                               chunkArea(it->second) - offset, {0, 0}, 0, WHITE);
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,219 @@
+#ifndef TEXT_HPP
+#define TEXT_HPP
+
+#include <charconv>
+#include <rlgl.h>
+#include "utils.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+/*
+ * a string in a fixed buffer, for building text every frame (like the debug overlay) without allocating
+ * anything that doesnt fit just gets cut off
+ */
+template<usize N>
+class FixedText {
+    array<char, N> buffer{};
+    usize length = 0;
+
+public:
+    FixedText& append(const string_view s) {
+        const usize n = std::min(s.size(), N - 1 - length);
+        std::copy_n(s.data(), n, buffer.data() + length);
+        length += n;
+        buffer[length] = '\0';
+        return *this;
+    }
+
+    FixedText& append(const char c) {
+        return append(string_view(&c, 1));
+    }
+
+    //with precision digits after the point, like str(value, precision)
+    FixedText& append(const double value, const i32 precision) {
+        const auto [end, error] = std::to_chars(buffer.data() + length, buffer.data() + N - 1, value,
+                                                chars_format::fixed, precision);
+        if (error == errc{}) length = end - buffer.data();
+        buffer[length] = '\0';
+        return *this;
+    }
+
+    template<integral T> requires (!same_as<T, char> && !same_as<T, bool>)
+    FixedText& append(const T value) {
+        const auto [end, error] = std::to_chars(buffer.data() + length, buffer.data() + N - 1, value);
+        if (error == errc{}) length = end - buffer.data();
+        buffer[length] = '\0';
+        return *this;
+    }
+
+    void clear() {
+        length = 0;
+        buffer[0] = '\0';
+    }
+
+    [[nodiscard]] string_view view() const {
+        return {buffer.data(), length};
+    }
+
+    [[nodiscard]] const char* data() const {
+        return buffer.data();
+    }
+};
+
+//the fonts that get baked into atlases when the text cache starts up
+enum class TextFont : u32 {
+    DEFAULT,//raylib's font, what DrawText uses
+    ALAGARD,//resources/alagard.ttf
+};
+
+/*
+ * draws text from baked font atlases, the quads for every glyph get laid out once and kept around (keyed by the
+ * text itself) until the text changes, so drawing the same text again is just handing the quads to raylib's batch
+ * the cache is a fixed size and every text can only go in a few slots, the one used least recently gets replaced, so
+ * once it's warmed up text that keeps changing doesnt allocate either
+ */
+class TextCache {
+    struct glyph_quad {
+        float x0, y0, x1, y1;//relative to where the text gets drawn
+        float u0, v0, u1, v1;
+    };
+
+    struct entry {
+        u64 hash = 0;
+        u64 last_used = 0;//0 if nothing was ever put here
+        string text;
+        TextFont font = TextFont::DEFAULT;
+        i32 size = 0;
+        vector<glyph_quad> quads;
+        fvec2 extent{};
+    };
+
+    array<Font, 2> fonts{};
+    vector<entry> entries;
+    u64 clock = 0;
+    usize hits = 0;
+    usize misses = 0;
+
+    TextCache() {
+        fonts[cast(TextFont::DEFAULT, usize)] = GetFontDefault();
+        //pixel font, baked big so it only ever gets scaled down, and sampled without filtering so it stays sharp
+        fonts[cast(TextFont::ALAGARD, usize)] = LoadFontEx("resources/alagard.ttf", 32, nullptr, 0);
+        SetTextureFilter(fonts[cast(TextFont::ALAGARD, usize)].texture, TEXTURE_FILTER_POINT);
+        entries.resize(capacity);
+    }
+
+    static u64 hashOf(const string_view text, const TextFont font, const i32 size) {
+        return hash<string_view>{}(text) ^ (cast(font, u64) << 56) ^ (cast(size, u64) * 0x9E3779B97F4A7C15ull);
+    }
+
+    //same layout as DrawTextEx
+    void layout(entry& e) const {
+        const Font& font = fonts[cast(e.font, usize)];
+        const float scale = cast(e.size, float) / cast(font.baseSize, float);
+        const float spacing = cast(e.size, float) / 10;//what DrawText uses
+        const float pad = cast(font.glyphPadding, float);
+        const auto tw = cast(font.texture.width, float);
+        const auto th = cast(font.texture.height, float);
+
+        e.quads.clear();
+        float x = 0, y = 0, width = 0;
+        const char* p = e.text.data();
+        const char* end = p + e.text.size();
+        while (p < end) {
+            i32 bytes = 0;
+            const i32 codepoint = GetCodepointNext(p, &bytes);
+            p += bytes;
+            if (codepoint == '\n') {
+                y += cast(e.size + 2, float);
+                x = 0;
+                continue;
+            }
+            const i32 index = GetGlyphIndex(font, codepoint);
+            const Rectangle& r = font.recs[index];
+            const GlyphInfo& g = font.glyphs[index];
+            if (codepoint != ' ' && codepoint != '\t') {
+                const float qx = x + cast(g.offsetX, float) * scale - pad * scale;
+                const float qy = y + cast(g.offsetY, float) * scale - pad * scale;
+                e.quads.push_back({
+                    qx, qy, qx + (r.width + pad*2) * scale, qy + (r.height + pad*2) * scale,
+                    (r.x - pad) / tw, (r.y - pad) / th, (r.x + r.width + pad) / tw, (r.y + r.height + pad) / th
+                });
+            }
+            x += (g.advanceX ? cast(g.advanceX, float) : r.width) * scale + spacing;
+            width = std::max(width, x - spacing);
+        }
+        e.extent = {width, y + cast(e.size, float)};
+    }
+
+    entry& find(const string_view text, const TextFont font, const i32 size) {
+        const u64 h = hashOf(text, font, size);
+        const usize start = h & (capacity - 1);
+        entry* victim = nullptr;
+        for (usize i = 0; i < ways; i++) {
+            entry& e = entries[(start + i) & (capacity - 1)];
+            if (e.last_used && e.hash == h && e.font == font && e.size == size && e.text == text) {
+                e.last_used = ++clock;
+                hits++;
+                return e;
+            }
+            if (!victim || e.last_used < victim->last_used) victim = &e;
+        }
+        //not laid out yet, it replaces whatever in its slots was used longest ago
+        misses++;
+        victim->hash = h;
+        victim->last_used = ++clock;
+        victim->text.assign(text);
+        victim->font = font;
+        victim->size = size;
+        layout(*victim);
+        return *victim;
+    }
+
+public:
+    static constexpr usize capacity = 512;//has to be a power of 2
+    static constexpr usize ways = 8;//how many slots a text can go in
+
+    TextCache(const TextCache&) = delete;
+    TextCache& operator =(const TextCache&) = delete;
+
+    static TextCache& instance() {
+        static TextCache cache;
+        return cache;
+    }
+
+    //like DrawText, but the layout is cached
+    void draw(const string_view text, const float x, const float y, const i32 size, const Color color,
+              const TextFont font = TextFont::DEFAULT) {
+        if (text.empty()) return;
+        const entry& e = find(text, font, size);
+        rlSetTexture(fonts[cast(font, usize)].texture.id);
+        rlBegin(RL_QUADS);
+        rlColor4ub(color.r, color.g, color.b, color.a);
+        rlNormal3f(0, 0, 1);
+        for (const auto& q: e.quads) {
+            rlTexCoord2f(q.u0, q.v0);
+            rlVertex2f(x + q.x0, y + q.y0);
+            rlTexCoord2f(q.u0, q.v1);
+            rlVertex2f(x + q.x0, y + q.y1);
+            rlTexCoord2f(q.u1, q.v1);
+            rlVertex2f(x + q.x1, y + q.y1);
+            rlTexCoord2f(q.u1, q.v0);
+            rlVertex2f(x + q.x1, y + q.y0);
+        }
+        rlEnd();
+        rlSetTexture(0);
+    }
+
+    //like MeasureTextEx, from the cache
+    fvec2 measure(const string_view text, const i32 size, const TextFont font = TextFont::DEFAULT) {
+        return find(text, font, size).extent;
+    }
+
+    //how many draws found their layout already cached, and how many had to lay it out
+    [[nodiscard]] pair<usize, usize> stats() const {
+        return {hits, misses};
+    }
+};
+
+#endif
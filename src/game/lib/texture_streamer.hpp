@@ -0,0 +1,145 @@
+#ifndef TEXTURE_STREAMER_HPP
+#define TEXTURE_STREAMER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <raylib.h>
+#include "AustinUtils.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+//an image off the streamer and whatever the decoder worked out from its pixels while it was at it
+struct DecodedImage {
+    Image image{};
+    bool translucent = false;//has pixels that are partly see through
+};
+
+/*
+ * decodes images on its own threads, the gl context only exists on the main thread so uploading them is left to
+ * whoever collects them (the Allocator, a few every frame)
+ * these threads are separate from the WorkerPool, a png can take a while to decode and the pool's threads have to be
+ * free for the frame's work
+ */
+class TextureStreamer {
+    using decoder_t = function<DecodedImage(const string&)>;
+
+    struct job {
+        string path;
+        shared_ptr<decoder_t> decode;
+    };
+
+    struct decoded {
+        string path;
+        DecodedImage image;
+    };
+
+    mutex m;
+    condition_variable wake;
+    condition_variable ready;
+    deque<job> jobs;
+    deque<decoded> done;
+    usize decoding = 0;
+    bool stopping = false;
+
+    vector<jthread> threads;//last, so they're joined before anything they use is destroyed
+
+    TextureStreamer() = default;
+
+    void workerLoop() {
+        while (true) {
+            unique_lock lock(m);
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping) return;
+            job j = std::move(jobs.front());
+            jobs.pop_front();
+            decoding++;
+            lock.unlock();
+
+            DecodedImage image = (*j.decode)(j.path);
+
+            lock.lock();
+            decoding--;
+            done.push_back({std::move(j.path), image});
+            ready.notify_all();
+        }
+    }
+
+    void start() {
+        if (!threads.empty()) return;
+        const u32 cores = std::max(2u, std::thread::hardware_concurrency());
+        //leaves the main thread its core, it's the one uploading
+        for (u32 i = 1; i < cores; i++) threads.emplace_back([this] { workerLoop(); });
+    }
+
+public:
+    static constexpr double upload_budget_ms = 2;//how long a frame can spend uploading textures
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator =(const TextureStreamer&) = delete;
+
+    ~TextureStreamer() {
+        {
+            lock_guard lock(m);
+            stopping = true;
+        }
+        wake.notify_all();
+        threads.clear();
+        for (auto& d: done) UnloadImage(d.image.image);
+    }
+
+    static TextureStreamer& instance() {
+        static TextureStreamer streamer;
+        return streamer;
+    }
+
+    //decode runs on the streamer's threads, so it has to be thread safe
+    void request(const vector<string>& paths, decoder_t decode) {
+        if (paths.empty()) return;
+        const auto shared = make_shared<decoder_t>(std::move(decode));
+        {
+            lock_guard lock(m);
+            start();
+            for (const auto& p: paths) jobs.push_back({p, shared});
+        }
+        wake.notify_all();
+    }
+
+    /*
+     * hands decoded images to upload (which owns them from then on) until budget_ms is used up, at least one always
+     * gets handed over if there is one, wait blocks until every requested image has been handed over instead
+     * returns how many were handed over
+     */
+    usize collect(const double budget_ms, const function<void(const string&, DecodedImage&)>& upload, const bool wait = false) {
+        const auto start_time = chrono::high_resolution_clock::now();
+        usize count = 0;
+        while (true) {
+            unique_lock lock(m);
+            if (wait) ready.wait(lock, [this] { return !done.empty() || (jobs.empty() && decoding == 0); });
+            if (done.empty()) return count;
+            decoded d = std::move(done.front());
+            done.pop_front();
+            lock.unlock();
+
+            upload(d.path, d.image);
+            count++;
+            const auto elapsed = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start_time);
+            if (!wait && elapsed.count() >= budget_ms) return count;
+        }
+    }
+
+    //images requested but not handed over yet
+    [[nodiscard]] usize pending() {
+        lock_guard lock(m);
+        return jobs.size() + decoding + done.size();
+    }
+
+    [[nodiscard]] usize threadCount() const {
+        return threads.size();
+    }
+};
+
+#endif
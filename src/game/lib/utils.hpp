@@ -13,6 +13,9 @@
 
 #include "enums.hpp"
 #include "json.hpp"
+#include "asset_pack.hpp"
+#include "texture_streamer.hpp"
+#include "file_saver.hpp"
 using namespace nlohmann;
 
 #define EXPAND_V(VEC) (VEC).x, (VEC).y
@@ -506,6 +509,20 @@ struct rect {
         return {x1, y1, intersectWidth, intersectHeight};
     }
 
+    //the smallest rect containing both rects
+    rect operator |(const rect& r2) const {
+        const double x1 = std::min(x, r2.x);
+        const double y1 = std::min(y, r2.y);
+        const double x2 = std::max(x + w, r2.x + r2.w);
+        const double y2 = std::max(y + h, r2.y + r2.h);
+
+        return {x1, y1, x2 - x1, y2 - y1};
+    }
+
+    bool operator ==(const rect& r) const {
+        return x == r.x && y == r.y && w == r.w && h == r.h;
+    }
+
     template<Arithmetic T>
     bool operator&&(const v2<T> v) {
         if (v.x < x) return false;
@@ -613,14 +630,36 @@ struct rect {
 
 const rect screen_rect = {0, 0, 1280, 720};
 
+/*
+ * lets something change how textures get loaded (see Allocator::setTextureLoader)
+ * prepare can change the pixels before they're uploaded, it runs on the texture streamer's threads so it has to be
+ * thread safe, uploaded gets every texture once it's on the gpu, on the main thread, evicted gets every texture
+ * right before it's unloaded for not being used (or for being replaced by a new one, see reloadTexture)
+ */
+struct TextureLoader {
+    function<void(const str& path, Image& image)> prepare;
+    function<void(const str& path, const Texture2D& texture)> uploaded;
+    function<void(const str& path, const Texture2D& texture)> evicted;
+};
+
 class Allocator {
     vector<void*> memory;
     unordered_map<str, Texture2D> textures;
     vector<RenderTexture2D> render_textures;
     vector<Shader> shaders;
+    TextureLoader loader;
+    Texture2D placeholder{};//what a texture is until it's done loading, shared by all of them
+    usize loading = 0;//textures waiting on the streamer
+    //textures in resources that got loaded because something used them and how much vram each takes, only these ever
+    //get evicted, textures grabbed with allocateTexture stay until they're freed
+    unordered_map<str, usize> streamed;
+    usize streamed_bytes = 0;
+    usize vram_budget = 256ull << 20;
+    bool keep_all = false;//every texture in resources stays loaded (the editor shows all of them)
+    unordered_set<u32> translucent;//the textures with pixels that are partly see through, see isTranslucent()
 
     template<typename T, typename vT>
-    static void free(T& x, vector<vT> vec, function<void(T&)> destroy) {
+    static void free(T& x, vector<vT>& vec, function<void(T&)> destroy) {
         auto it = std::find(vec.begin(), vec.end(), x);
 
         if (it == vec.end()) throw Exception("Cannot free object at ", &x, " as it is not allocated by this allocator");
@@ -629,7 +668,7 @@ class Allocator {
     }
 
     template<typename T, typename vT>
-    static void free(T& x, vector<vT> vec, function<void(T&)> destroy, function<bool(vT&)> predicate) {
+    static void free(T& x, vector<vT>& vec, function<void(T&)> destroy, function<bool(vT&)> predicate) {
         auto it = std::find_if(vec.begin(), vec.end(), std::move(predicate));
 
         if (it == vec.end()) throw Exception("Cannot free object at ", &x, " as it is not allocated by this allocator");
@@ -638,12 +677,139 @@ class Allocator {
     }
 
     explicit Allocator() {
-        //load EVERY texture in resources so we dont waste time loading them on-the-fly
+        //textures only get loaded once a level (or anything else) uses them, see AnimationRegistry::updateResidency
+        Image checker = GenImageChecked(2, 2, 1, 1, MAGENTA, BLACK);
+        placeholder = LoadTextureFromImage(checker);
+        UnloadImage(checker);
+    }
+
+    //decodes and prepares a texture's pixels, on whatever thread calls it, so the streamer does the alpha scan too
+    DecodedImage decode(const str& path) const {
+        DecodedImage ret{loadImage(path)};
+        if (loader.prepare && ret.image.data) loader.prepare(path, ret.image);
+        ret.translucent = hasPartialAlpha(ret.image);
+        return ret;
+    }
+
+    //true if any pixel is neither fully see through nor solid
+    static bool hasPartialAlpha(const Image& image) {
+        if (!image.data) return false;
+        const usize pixels = cast(image.width, usize) * cast(image.height, usize);
+        const auto partial = [&image, pixels](const usize stride, const usize alpha) {
+            const auto* bytes = cast(image.data, const u8*);
+            for (usize i = 0; i < pixels; i++) {
+                const u8 a = bytes[i * stride + alpha];
+                if (a > 0 && a < 255) return true;
+            }
+            return false;
+        };
+        switch (image.format) {
+            case PIXELFORMAT_UNCOMPRESSED_R8G8B8A8:
+                return partial(4, 3);
+            case PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA:
+                return partial(2, 1);
+            case PIXELFORMAT_UNCOMPRESSED_GRAYSCALE:
+            case PIXELFORMAT_UNCOMPRESSED_R5G6B5:
+            case PIXELFORMAT_UNCOMPRESSED_R8G8B8:
+            case PIXELFORMAT_UNCOMPRESSED_R32:
+            case PIXELFORMAT_UNCOMPRESSED_R32G32B32:
+            case PIXELFORMAT_UNCOMPRESSED_R16:
+            case PIXELFORMAT_UNCOMPRESSED_R16G16B16:
+                return false;
+            default:
+                break;
+        }
+        //raylib cant read compressed pixels back, so those might as well be
+        if (image.format >= PIXELFORMAT_COMPRESSED_DXT1_RGB) return true;
+        Color* colors = LoadImageColors(image);
+        const bool ret = std::any_of(colors, colors + pixels, [](const Color c) { return c.a > 0 && c.a < 255; });
+        UnloadImageColors(colors);
+        return ret;
+    }
+
+    void noteAlpha(const Texture2D& texture, const bool partial) {
+        if (partial) translucent.insert(texture.id);
+        else translucent.erase(texture.id);
+    }
+
+    Texture2D upload(const str& path, DecodedImage& decoded) {
+        const Texture2D texture = LoadTextureFromImage(decoded.image);
+        noteAlpha(texture, decoded.translucent);
+        UnloadImage(decoded.image);
+        if (loader.uploaded) loader.uploaded(path, texture);
+        cout << "Allocating texture: " << path.data() << "\n";
+        return texture;
+    }
+
+    //starts loading every texture that isnt loaded yet on the streamer, they're the placeholder until they're uploaded
+    void request(const vector<string>& paths) {
+        vector<string> missing;
+        for (const auto& p: paths) {
+            string s = normalizeAssetPath(p);
+            if (textures.contains(s)) continue;
+            textures[s] = placeholder;
+            streamed.try_emplace(s, 0);
+            missing.push_back(std::move(s));
+        }
+        loading += missing.size();
+        TextureStreamer::instance().request(missing, [this](const string& path) { return decode(path); });
+    }
+
+    //uploads whatever the streamer has finished, returns how many got uploaded
+    usize collect(const double budget_ms, const bool wait) {
+        return TextureStreamer::instance().collect(budget_ms, [this](const string& path, DecodedImage& decoded) {
+            loading--;
+            const auto it = textures.find(path);
+            //freed while it was loading
+            if (it == textures.end() || it->second.id != placeholder.id) {
+                UnloadImage(decoded.image);
+                return;
+            }
+            const Image& image = decoded.image;
+            const auto bytes = cast(GetPixelDataSize(image.width, image.height, image.format), usize);
+            it->second = upload(path, decoded);
+            if (const auto s = streamed.find(path); s != streamed.end()) {
+                streamed_bytes = streamed_bytes - s->second + bytes;
+                s->second = bytes;
+            }
+        }, wait);
+    }
+
+    void finishLoading() {
+        while (loading > 0) collect(0, true);
+    }
+
+    void evict(const str& path) {
+        const auto s = streamed.find(path);
+        if (s == streamed.end()) return;
+        streamed_bytes -= s->second;
+        streamed.erase(s);
+        const auto it = textures.find(path);
+        if (it == textures.end()) return;
+        //still loading, the streamer throws it away once it's decoded
+        if (it->second.id != placeholder.id) {
+            if (loader.evicted) loader.evicted(path, it->second);
+            translucent.erase(it->second.id);
+            UnloadTexture(it->second);
+        }
+        textures.erase(it);
+    }
+
+    //every texture in resources, out of the asset pack if there is one so the disk doesnt have to be walked
+    static vector<string> texturePaths() {
+        vector<string> ret;
+        if (const AssetPack& pack = AssetPack::instance(); pack.isOpen()) {
+            for (const auto& e: pack.entries()) {
+                if (AssetPack::isImage(e) && pack.name(e).starts_with("resources/")) ret.emplace_back(pack.name(e));
+            }
+            return ret;
+        }
         for (const auto& entry: filesystem::recursive_directory_iterator("resources")) {
             if (entry.is_regular_file() && entry.path().extension() == ".png") {
-                IallocateTexture(entry.path().string().data());
+                ret.push_back(entry.path().string());
             }
         }
+        return ret;
     }
 
 public:
@@ -663,7 +829,115 @@ public:
         return instance().Iallocate(amt);
     }
 
-    static void reloadTextures(bool delete_previous, bool& finished);
+    /*
+     * loads every texture in resources again on the streamer, the ones that get reloaded are the placeholder until
+     * they're uploaded by uploadTextures, wait uploads all of them before returning instead
+     * delete_previous reloads the ones that are already loaded too, otherwise only new files get loaded
+     */
+    static void reloadTextures(bool delete_previous, bool wait = false);
+
+    /*
+     * uploads textures the streamer finished decoding for up to budget_ms, call it once a frame
+     * returns true on the frame the last one gets uploaded, animations get their textures again then
+     */
+    static bool uploadTextures(double budget_ms);
+
+    [[nodiscard]] static bool loadingTextures() {
+        return instance().loading > 0;
+    }
+
+    //starts loading the textures that arent loaded yet, they're the placeholder until they're uploaded unless wait
+    static void requestTextures(const vector<string>& paths, const bool wait = false) {
+        instance().request(paths);
+        if (wait) instance().finishLoading();
+    }
+
+    //the texture if it's loaded (or loading), the placeholder otherwise, never loads anything
+    static Texture2D findTexture(const str& path) {
+        const auto it = instance().textures.find(normalizeAssetPath(path.data()));
+        return it == instance().textures.end() ? instance().placeholder : it->second;
+    }
+
+    /*
+     * true if the texture has pixels that are partly see through (worked out when it's decoded), those have to be
+     * blended instead of cut out by DepthSorter's alpha test
+     */
+    [[nodiscard]] static bool isTranslucent(const Texture2D& texture) {
+        return instance().translucent.contains(texture.id);
+    }
+
+    [[nodiscard]] static u32 placeholderId() {
+        return instance().placeholder.id;
+    }
+
+    //the textures that can be evicted
+    static vector<str> streamedTextures() {
+        vector<str> ret;
+        for (const auto& path: instance().streamed | views::keys) ret.push_back(path);
+        return ret;
+    }
+
+    //how much vram the textures that can be evicted take
+    [[nodiscard]] static usize streamedBytes() {
+        return instance().streamed_bytes;
+    }
+
+    [[nodiscard]] static usize textureBudget() {
+        return instance().vram_budget;
+    }
+
+    //evicts the textures in order until the rest fit in budget bytes, returns how many got evicted
+    static usize evictTextures(const vector<str>& order, const usize budget) {
+        Allocator& a = instance();
+        if (a.keep_all) return 0;
+        usize evicted = 0;
+        for (const auto& path: order) {
+            if (a.streamed_bytes <= budget) break;
+            if (!a.streamed.contains(path)) continue;
+            a.evict(path);
+            evicted++;
+        }
+        return evicted;
+    }
+
+    //loads every texture in resources and never evicts any of them, for the editor
+    static void keepAllTextures();
+
+    /*
+     * loads a texture that changed on disk again, if it's the same size and format the new pixels go into the texture
+     * it already has, so everything holding it keeps working, otherwise it gets a new one and animations get it again
+     * textures that arent loaded are left alone (unless every texture is kept loaded), they're new once they do load
+     */
+    static void reloadTexture(const str& path);
+
+    static json defaultConfig() {
+        return {{"vram_budget_mb", 256}};
+    }
+
+    static bool validateConfig(const json& config);
+
+    //how much vram textures that arent being used can take before the least recently used ones get evicted
+    static void configure(const json& config) {
+        instance().vram_budget = cast(std::max(0.0, config["vram_budget_mb"].get<double>()) * 1024 * 1024, usize);
+    }
+
+    //every texture loaded from now on goes through the loader, textures that are loading already get finished first
+    static void setTextureLoader(TextureLoader l) {
+        instance().finishLoading();
+        instance().loader = std::move(l);
+    }
+
+    //what a texture gets loaded with when there isnt a texture loader, out of the asset pack if it's in there
+    static Texture2D loadTexture(const str& path) {
+        if (const auto texture = AssetPack::instance().loadTexture(path.data())) return *texture;
+        return LoadTexture(path.data());
+    }
+
+    //like loadTexture, but the pixels, for texture loaders that change them first
+    static Image loadImage(const str& path) {
+        if (const auto image = AssetPack::instance().loadImage(path.data())) return *image;
+        return LoadImage(path.data());
+    }
 
     static Texture2D allocateTexture(const char* filename) {
         return instance().IallocateTexture(filename);
@@ -744,15 +1018,17 @@ private:
     }
 
     Texture2D IallocateTexture(const char* filename) {
-        string f = filesystem::relative(filename).generic_string();
-        for (auto& c: f) {
-            if (c == '\\') c = '/';
-        }
-        str s = f;
+        str s = normalizeAssetPath(filename);
         if (textures.contains(s.data())) cout << "Texture: " << s.data() << " already exists!";
+        //whoever asked for it holds onto it, so it cant be evicted anymore
+        if (const auto st = streamed.find(s); st != streamed.end()) {
+            streamed_bytes -= st->second;
+            streamed.erase(st);
+        }
+        //the pixels go through decode() either way, so it knows whether the texture is translucent
         if (!textures.contains(s.data())) {
-            textures[s.data()] = LoadTexture(s.data());
-            cout << "Allocating texture: " << s.data() << "\n";
+            DecodedImage decoded = decode(s);
+            textures[s.data()] = upload(s, decoded);
         }
         return textures[s.data()];
     }
@@ -787,7 +1063,16 @@ private:
             return p.second.id == texture.id;
         });
 
-        UnloadTexture(it->second);
+        if (it == textures.end()) return;
+        if (const auto st = streamed.find(it->first); st != streamed.end()) {
+            streamed_bytes -= st->second;
+            streamed.erase(st);
+        }
+        //the placeholder is shared, it's only unloaded with everything else
+        if (it->second.id != placeholder.id) {
+            translucent.erase(it->second.id);
+            UnloadTexture(it->second);
+        }
         textures.erase(it);
     }
 
@@ -817,9 +1102,13 @@ private:
         }
         memory.clear();
         for (const auto &texture: textures | views::values) {
-            UnloadTexture(texture);
+            if (texture.id != placeholder.id) UnloadTexture(texture);
         }
         textures.clear();
+        streamed.clear();
+        streamed_bytes = 0;
+        if (placeholder.id) UnloadTexture(placeholder);
+        placeholder = {};
         for (const auto& rtexture: render_textures) {
             UnloadRenderTexture(rtexture);
         }
@@ -887,6 +1176,7 @@ private:
     animation_type typ;
     str id;
     str path;
+    u64 last_used = 0;//the last frame something besides the registry held it, see AnimationRegistry::updateResidency
     friend struct AnimationRegistry;
 public:
 
@@ -956,6 +1246,21 @@ public:
         return floor(max_keyframe);
     }
 
+    //true if the animation's texture is partly see through anywhere, see Allocator::isTranslucent
+    NODISCARD bool isTranslucent() const {
+        return Allocator::isTranslucent(texture);
+    }
+
+    //true if drawing this animation will always give the same result
+    NODISCARD bool isStatic() const {
+        return typ == animation_type::NONE || getMaxFrame() <= 1;
+    }
+
+    //true if the frame only depends on how long it's been playing, so it never needs update() and can be batched
+    NODISCARD bool isStateless() const {
+        return typ == animation_type::LOOP && getMaxFrame() > 1 && frame_duration > 0;
+    }
+
     void setFramePos(const i32 x) {
         keyframe = clamp(x, 0, max_keyframe);
     }
@@ -1049,8 +1354,9 @@ inline void DrawAnimation(animation& anim, const rect& source, dvec2 pos, Color
  */
 
 template<typename... Args, typename = std::enable_if_t< ( ( (is_same_v<Args, json::value_t>) && ...) ) >>
-bool validateJsonData(json data, const str& key, Args... type) {
-    if (!data.contains(key.data()) || ((data[key.data()].type() != type) && ...)) {
+bool validateJsonData(const json& data, const str& key, Args... type) {
+    const auto it = data.find(key.data());
+    if (it == data.end() || ((it->type() != type) && ...)) {
 
         return false;
     }
@@ -1058,8 +1364,8 @@ bool validateJsonData(json data, const str& key, Args... type) {
 }
 
 template<typename... Args, typename = std::enable_if_t< ( ( (is_same_v<Args, json::value_t>) && ...) ) >>
-bool assertJsonData(json data, const str& key, Args... type) {
-    if (!data.contains(key.data()) || ((data[key.data()].type() != type) && ...)) {
+bool assertJsonData(const json& data, const str& key, Args... type) {
+    if (!validateJsonData(data, key, type...)) {
         throw Exception("Error parsing json, could not find key: ", key, " or key is not any of types: [ ",
                         ((str(json::type_name(type)) + " "), ...));
     }
@@ -1067,8 +1373,8 @@ bool assertJsonData(json data, const str& key, Args... type) {
 }
 
 template<typename... Args, typename = std::enable_if_t< ( ( (is_same_v<Args, json::value_t>) && ...) ) >>
-bool assertJsonData(json data, const str& key, str error_message, Args... type) {
-    if (!data.contains(key.data()) || ((data[key.data()].type() != type) && ...)) {
+bool assertJsonData(const json& data, const str& key, str error_message, Args... type) {
+    if (!validateJsonData(data, key, type...)) {
         throw Exception("Error parsing json, could not find key: ", key, " or key is not any of types: [ ",
                         ((str(json::type_name(type)) + " "), ...));
     }
@@ -1083,6 +1389,25 @@ struct AnimationRegistry {
 
     logger LAnimationRegistry = logger("animation-registry");
 
+    u64 frame = 0;
+    usize over_budget_bytes = 0;//what the textures took the last time they didnt fit in the budget
+
+    unordered_map<str, json> saved;//what every animation's file has in it, so saving only writes the ones that changed
+
+    static string texturePath(const str& path) {
+        return ("resources/"_str + path).stdStr();
+    }
+
+    //what goes in the animation's file
+    static json animationJson(const animation& anim) {
+        json dat;
+        dat["path"] = anim.path;
+        dat["frame_height"] = anim.frame_height;
+        dat["frame_duration"] = anim.frame_duration;
+        dat["type"] = cast(anim.typ, u32);
+        return dat;
+    }
+
     static bool validateData(json& data) {
         if (!validateJsonData(data, "path", json::value_t::string)) {
             return false;
@@ -1100,23 +1425,44 @@ struct AnimationRegistry {
         return true;
     }
 
-    //helper function to load animations
+    //helper function to load animations, an animation that's already loaded gets changed in place
     void add(const str& id) {
-        std::ifstream jsonFile(("data/animation"_str + "/" + id + ".json").data());
-        if (!jsonFile.is_open()) throw Exception("Could not find json file for identifier ", id);
-
+        const str file = "data/animation"_str + "/" + id + ".json";
         json AnimationData;
-        jsonFile >> AnimationData;
-        jsonFile.close();
+        if (const auto packed = AssetPack::instance().text(file.data())) {
+            AnimationData = json::parse(*packed);
+        } else {
+            std::ifstream jsonFile(file.data());
+            if (!jsonFile.is_open()) throw Exception("Could not find json file for identifier ", id);
+            jsonFile >> AnimationData;
+            jsonFile.close();
+        }
         if (!validateData(AnimationData)) {
             throw Exception("Could not create animation from json file pointed by identifier ", id);
         }
-        animations[id] = make_shared<animation>(("resources/"_str + str(AnimationData["path"].get<string>())).data(),
+        if (const auto it = animations.find(id); it != animations.end()) {
+            animation& anim = *it->second;
+            anim.path = AnimationData["path"].get<string>();
+            anim.frame_height = cast(AnimationData["frame_height"].get<u32>(), i32);
+            anim.frame_duration = AnimationData["frame_duration"].get<double>();
+            anim.typ = cast(AnimationData["type"].get<u32>(), animation_type);
+            anim.texture = Allocator::findTexture(texturePath(anim.path));
+            if (anim.frame_height > 0) {
+                anim.max_keyframe = std::max(1.0, round(cast(anim.texture.height, double)/cast(anim.frame_height, double)));
+            }
+            anim.keyframe = std::min(anim.keyframe, anim.max_keyframe);
+            saved[id] = animationJson(anim);
+            LAnimationRegistry.info("Reloaded animation: ", id);
+            return;
+        }
+        //the texture gets loaded once something uses the animation
+        animations[id] = make_shared<animation>(Allocator::findTexture(texturePath(AnimationData["path"].get<string>())),
                                                 AnimationData["frame_height"].get<u32>(),
                                                 AnimationData["frame_duration"].get<double>(),
                                                 cast(AnimationData["type"].get<u32>(), animation_type));
         animations[id]->id = id;
         animations[id]->path = AnimationData["path"].get<string>();
+        saved[id] = animationJson(*animations[id]);
         LAnimationRegistry.info("Created animation: ", id);
 
     }
@@ -1127,10 +1473,18 @@ struct AnimationRegistry {
 
     AnimationRegistry() {
         try {
-            for (const auto& entry: filesystem::directory_iterator("data/animation")) {
-                if (entry.is_regular_file() && entry.path().extension() == ".json") {
-                    cout << "id: " << entry.path().stem().generic_string() << "\n";
-                    add(str(entry.path().stem().generic_string()));
+            //the asset pack has every animation, so data/animation doesnt have to be walked
+            if (const AssetPack& pack = AssetPack::instance(); pack.isOpen()) {
+                for (const auto& e: pack.entries()) {
+                    if (e.type != AssetType::ANIMATION) continue;
+                    add(str(filesystem::path(pack.name(e)).stem().generic_string()));
+                }
+            } else {
+                for (const auto& entry: filesystem::directory_iterator("data/animation")) {
+                    if (entry.is_regular_file() && entry.path().extension() == ".json") {
+                        cout << "id: " << entry.path().stem().generic_string() << "\n";
+                        add(str(entry.path().stem().generic_string()));
+                    }
                 }
             }
         } catch (exception& e) {
@@ -1150,17 +1504,31 @@ struct AnimationRegistry {
         return ret;
     }
 
-    void saveAnimations() {
+    //queues the animations that changed since they were loaded (or last saved) on the FileSaver, returns how many did
+    usize saveAnimations() {
+        usize queued = 0;
         for (auto&[id, anim]: animations) {
-            ofstream outfile(("data/animation/"_str + id + ".json").data());
-            json dat;
-            dat["path"] = anim->path;
-            dat["frame_height"] = anim->height();
-            dat["frame_duration"] = anim->duration();
-            dat["type"] = cast(anim->type(), u32);
-            outfile << dat.dump(4);
-            outfile.close();
+            json dat = animationJson(*anim);
+            if (const auto it = saved.find(id); it != saved.end() && it->second == dat) continue;
+            saved[id] = dat;//so it isnt queued again while it's written, saveFailed() takes it back
+            const string file = ("data/animation/"_str + id + ".json").stdStr();
+            FileSaver::instance().save(file, [dat = std::move(dat)](const string& temp) {
+                ofstream outfile(temp);
+                if (!outfile.is_open()) throw Exception("Could not write animation ", temp);
+                outfile << dat.dump(4);
+                outfile.close();
+                if (!outfile) throw Exception("Could not write animation ", temp);
+            });
+            queued++;
         }
+        return queued;
+    }
+
+    //for a file from saveAnimations() that couldnt be written, the animation gets written again on the next save
+    void saveFailed(const string& path) {
+        const filesystem::path p(path);
+        if (p.parent_path() != "data/animation" || p.extension() != ".json") return;
+        saved.erase(str(p.stem().generic_string()));
     }
 
     bool Register(const str& path, const str& id, const double duration, const i32 height, const animation_type typ) {
@@ -1171,18 +1539,96 @@ struct AnimationRegistry {
         }
         if (id.empty()) return false;
         if (animations.contains(id)) return false;
-        animations[id] = make_shared<animation>(animation(("resources/" + path).data(), height, duration, typ));
+        Allocator::requestTextures({texturePath(path)}, true);
+        animations[id] = make_shared<animation>(animation(Allocator::findTexture(texturePath(path)), height, duration, typ));
         animations[id]->id = id;
         animations[id]->path = path;
         return true;
     }
 
+    //reads the animation's json again, everything holding the animation sees the change
+    void reloadAnimation(const str& id) {
+        add(id);
+    }
+
+    //gives every animation its texture again, the placeholder if it isnt loaded
     void reload() {
         for (auto &anim: animations | views::values) {
-            anim->texture = Allocator::getTexture("resources/"_str + anim->path);
+            if (anim->path.empty()) continue;
+            const i32 old_height = anim->texture.height;
+            anim->texture = Allocator::findTexture(texturePath(anim->path));
+            //it was (or now is) a placeholder, so it has a different number of frames
+            if (anim->texture.height != old_height && anim->frame_height > 0) {
+                anim->max_keyframe = std::max(1.0, round(cast(anim->texture.height, double)/cast(anim->frame_height, double)));
+            }
+        }
+    }
+
+    //loads the animations' textures before anything uses them, so they never get drawn as the placeholder
+    void preload(const vector<str>& ids) {
+        vector<string> paths;
+        for (const auto& id: ids) {
+            const auto it = animations.find(id);
+            if (it != animations.end() && !it->second->path.empty()) paths.push_back(texturePath(it->second->path));
+        }
+        Allocator::requestTextures(paths, true);
+        reload();
+    }
+
+    /*
+     * once a frame on the main thread, while nothing else can be grabbing animations
+     * an animation is in use while anything besides the registry holds it, the ones in use that arent loaded start
+     * loading (they're the placeholder until Allocator::uploadTextures gets to them), and if the textures dont fit in
+     * the budget anymore the ones nothing uses get evicted
+     */
+    void updateResidency() {
+        frame++;
+        vector<string> missing;
+        for (auto& anim: animations | views::values) {
+            if (anim.use_count() == 1) continue;
+            anim->last_used = frame;
+            if (anim->texture.id == Allocator::placeholderId() && !anim->path.empty()) {
+                missing.push_back(texturePath(anim->path));
+            }
+        }
+        if (!missing.empty()) Allocator::requestTextures(missing);
+
+        const usize bytes = Allocator::streamedBytes();
+        //nothing changed since the last time everything that could be evicted was
+        if (bytes <= Allocator::textureBudget() || bytes == over_budget_bytes) return;
+        trimTextures(Allocator::textureBudget());
+        if (Allocator::streamedBytes() > Allocator::textureBudget()) {
+            over_budget_bytes = Allocator::streamedBytes();
+            LAnimationRegistry.warn("Textures in use take ", over_budget_bytes / (1024 * 1024), " MB, over the ",
+                                    Allocator::textureBudget() / (1024 * 1024), " MB budget");
         }
     }
 
+    //evicts textures no animation in use needs, least recently used first, until the rest fit in budget bytes
+    usize trimTextures(const usize budget) {
+        //textures no animation points to stay 0, so they go first
+        unordered_map<str, u64> last_used;
+        for (const auto& path: Allocator::streamedTextures()) last_used[path] = 0;
+        for (auto& anim: animations | views::values) {
+            if (anim->path.empty()) continue;
+            const auto it = last_used.find(normalizeAssetPath(texturePath(anim->path)));
+            if (it == last_used.end()) continue;
+            if (anim.use_count() > 1) last_used.erase(it);
+            else it->second = std::max(it->second, anim->last_used);
+        }
+        vector<pair<u64, str>> stamped;
+        for (const auto& [path, stamp]: last_used) stamped.emplace_back(stamp, path);
+        ranges::sort(stamped, {}, &pair<u64, str>::first);
+        vector<str> order;
+        for (auto& path: stamped | views::values) order.push_back(std::move(path));
+        const usize evicted = Allocator::evictTextures(order, budget);
+        if (evicted > 0) {
+            reload();
+            LAnimationRegistry.info("Evicted ", evicted, " textures, ", Allocator::streamedBytes() / 1024, " KB left");
+        }
+        return evicted;
+    }
+
     static AnimationRegistry& Instance() {
         static AnimationRegistry instance;
         return instance;
@@ -1199,20 +1645,86 @@ struct AnimationRegistry {
 };
 
 
-inline void Allocator::reloadTextures(bool delete_previous, bool &finished)  {
+inline void Allocator::reloadTextures(const bool delete_previous, const bool wait)  {
+    Allocator& a = instance();
+    //without keep_all only the textures that are loaded right now get reloaded
+    vector<string> paths;
+    if (a.keep_all) paths = texturePaths();
+    else for (const auto& p: a.streamed | views::keys) paths.push_back(p.stdStr());
     if (delete_previous) {
-        for (auto &text: instance().textures | views::values) {
-            UnloadTexture(text);
+        a.finishLoading();
+        //only the ones in resources get reloaded, anything else is left alone
+        for (const auto& p: paths) {
+            const auto it = a.textures.find(normalizeAssetPath(p));
+            if (it == a.textures.end()) continue;
+            if (const auto s = a.streamed.find(it->first); s != a.streamed.end()) {
+                a.streamed_bytes -= s->second;
+                s->second = 0;
+            }
+            a.translucent.erase(it->second.id);
+            UnloadTexture(it->second);
+            a.textures.erase(it);
         }
-        instance().textures.clear();
     }
-    for (const auto& entry: filesystem::recursive_directory_iterator("resources")) {
-        if (entry.is_regular_file() && entry.path().extension() == ".png") {
-            instance().IallocateTexture(entry.path().string().data());
-        }
+    a.request(paths);
+    //the textures that were deleted are placeholders now
+    AnimationRegistry::Instance().reload();
+    if (wait) {
+        a.finishLoading();
+        AnimationRegistry::Instance().reload();
     }
+}
+
+inline bool Allocator::uploadTextures(const double budget_ms) {
+    Allocator& a = instance();
+    if (a.loading == 0) return false;
+    a.collect(budget_ms, false);
+    if (a.loading > 0) return false;
     AnimationRegistry::Instance().reload();
-    finished = true;
+    return true;
+}
+
+inline void Allocator::reloadTexture(const str& file) {
+    Allocator& a = instance();
+    const str path = normalizeAssetPath(file.data());
+    const auto it = a.textures.find(path);
+    if (it == a.textures.end()) {
+        if (a.keep_all) a.request({path.stdStr()});
+        return;
+    }
+    //still loading, the streamer reads the file after it changed anyway
+    if (it->second.id == a.placeholder.id) return;
+    DecodedImage decoded = a.decode(path);
+    Image& image = decoded.image;
+    if (!image.data) return;
+    Texture2D& texture = it->second;
+    if (image.width == texture.width && image.height == texture.height && image.format == texture.format &&
+        texture.mipmaps == 1) {
+        UpdateTexture(texture, image.data);
+        a.noteAlpha(texture, decoded.translucent);
+        UnloadImage(image);
+        if (a.loader.uploaded) a.loader.uploaded(path, texture);
+        return;
+    }
+    const auto bytes = cast(GetPixelDataSize(image.width, image.height, image.format), usize);
+    if (a.loader.evicted) a.loader.evicted(path, texture);
+    a.translucent.erase(texture.id);
+    UnloadTexture(texture);
+    texture = a.upload(path, decoded);
+    if (const auto s = a.streamed.find(path); s != a.streamed.end()) {
+        a.streamed_bytes = a.streamed_bytes - s->second + bytes;
+        s->second = bytes;
+    }
+    AnimationRegistry::Instance().reload();
+}
+
+inline void Allocator::keepAllTextures() {
+    instance().keep_all = true;
+    reloadTextures(false, true);
+}
+
+inline bool Allocator::validateConfig(const json& config) {
+    return validateJsonData(config, "vram_budget_mb", JSON_NUMBERS);
 }
 
 
@@ -0,0 +1,124 @@
+#ifndef WORKERS_HPP
+#define WORKERS_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "utils.hpp"
+
+using namespace AustinUtils;
+using namespace std;
+
+/*
+ * a fixed set of threads that stay around for the whole program, so splitting work across cores every frame
+ * doesnt cost a thread creation every time
+ * the thread that calls parallelFor helps out too, so with one core everything just runs inline
+ */
+class WorkerPool {
+    mutex m;
+    condition_variable wake;
+    condition_variable done;
+    bool stopping = false;
+
+    //the current job, only changed while nobody is working on it
+    const function<void(usize)>* job = nullptr;
+    usize job_count = 0;
+    usize generation = 0;
+    atomic<usize> next{0};
+    usize finished = 0;
+    usize active = 0;//workers currently inside of a job
+
+    vector<jthread> threads;//last, so they're joined before anything they use is destroyed
+
+    WorkerPool() {
+        const u32 cores = std::thread::hardware_concurrency();
+        for (u32 i = 1; i < cores; i++) {
+            threads.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    void work(const function<void(usize)>& f, const usize count) {
+        usize did = 0;
+        for (usize i; (i = next.fetch_add(1)) < count;) {
+            f(i);
+            did++;
+        }
+        if (did == 0) return;
+        lock_guard lock(m);
+        finished += did;
+        if (finished == job_count) done.notify_all();
+    }
+
+    void workerLoop() {
+        usize seen = 0;
+        while (true) {
+            unique_lock lock(m);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            if (!job) continue;
+
+            const auto* f = job;
+            const usize count = job_count;
+            active++;
+            lock.unlock();
+
+            work(*f, count);
+
+            lock.lock();
+            active--;
+            if (active == 0) done.notify_all();
+        }
+    }
+
+public:
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator =(const WorkerPool&) = delete;
+
+    ~WorkerPool() {
+        {
+            lock_guard lock(m);
+            stopping = true;
+        }
+        wake.notify_all();
+    }
+
+    static WorkerPool& instance() {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    //how many threads can work at once, including the one calling parallelFor
+    [[nodiscard]] usize concurrency() const {
+        return threads.size() + 1;
+    }
+
+    //calls f(0) to f(count-1) spread across every core and waits for all of them, f has to be thread safe
+    void parallelFor(const usize count, const function<void(usize)>& f) {
+        if (count == 0) return;
+        if (threads.empty() || count == 1) {
+            for (usize i = 0; i < count; i++) f(i);
+            return;
+        }
+
+        {
+            lock_guard lock(m);
+            job = &f;
+            job_count = count;
+            finished = 0;
+            next = 0;
+            generation++;
+        }
+        wake.notify_all();
+
+        work(f, count);
+
+        unique_lock lock(m);
+        //waiting on active too so no worker is still holding onto f once we return
+        done.wait(lock, [&] { return finished == job_count && active == 0; });
+        job = nullptr;
+    }
+};
+
+#endif
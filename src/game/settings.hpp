@@ -1,5 +1,10 @@
 #include <unordered_set>
 #include "lib/utils.hpp"
+#include "lib/post.hpp"
+#include "lib/dynamic_resolution.hpp"
+#include "lib/frame_pacer.hpp"
+#include "lib/palette.hpp"
+#include "lib/globals.hpp"
 
 #ifndef SETTINGS_HPP
 #define SETTINGS_HPP
@@ -10,6 +15,19 @@ struct keybind {
     str description;
 };
 
+//what a keybind was doing when settings::captureKeybinds() was called
+struct keybind_state {
+    bool down = false;
+    bool pressed = false;
+    bool released = false;
+    bool up = true;
+};
+
+//while this is on the IsKeybind functions read what was captured instead of asking raylib, so the game can update on
+//another thread while raylib polls input (see FramePipeline)
+inline bool use_captured_keybinds = false;
+inline unordered_map<const keybind*, keybind_state> captured_keybinds;
+
 inline json makeJObjectFromKeybind(str name, const keybind& k) {
     json ret;
     ret["id"] = name.stdStr();
@@ -48,6 +66,52 @@ private:
             KeybindRegistry::instance()[name].mouse = obj["mouse"].get<i32>();
         }
 
+        //the post processing chain
+        if (!validateJsonData(data, "post_processing", json::value_t::array) ||
+            !PostChain::validateConfig(data["post_processing"])) {
+            LSettings.warn("No valid post processing chain in settings.json, using the default one");
+            data["post_processing"] = PostChain::defaultConfig();
+        }
+        post_processing = data["post_processing"];
+
+        //dynamic resolution
+        if (!validateJsonData(data, "dynamic_resolution", json::value_t::object) ||
+            !DynamicResolution::validateConfig(data["dynamic_resolution"])) {
+            LSettings.warn("No valid dynamic resolution settings in settings.json, using the defaults");
+            data["dynamic_resolution"] = DynamicResolution::defaultConfig();
+        }
+        dynamic_resolution = data["dynamic_resolution"];
+
+        //frame rate cap
+        if (!validateJsonData(data, "frame_pacing", json::value_t::object) ||
+            !FramePacer::validateConfig(data["frame_pacing"])) {
+            LSettings.warn("No valid frame pacing settings in settings.json, using the defaults");
+            data["frame_pacing"] = FramePacer::defaultConfig();
+        }
+        frame_pacing = data["frame_pacing"];
+
+        //indexed color
+        if (!validateJsonData(data, "indexed_color", json::value_t::object) ||
+            !IndexedColor::validateConfig(data["indexed_color"])) {
+            LSettings.warn("No valid indexed color settings in settings.json, using the defaults");
+            data["indexed_color"] = IndexedColor::defaultConfig();
+        }
+        indexed_color = data["indexed_color"];
+
+        //texture residency
+        if (!validateJsonData(data, "texture_residency", json::value_t::object) ||
+            !Allocator::validateConfig(data["texture_residency"])) {
+            LSettings.warn("No valid texture residency settings in settings.json, using the defaults");
+            data["texture_residency"] = Allocator::defaultConfig();
+        }
+        texture_residency = data["texture_residency"];
+
+        //depth buffer sorting
+        if (!validateJsonData(data, "depth_sorting", json::value_t::boolean)) {
+            data["depth_sorting"] = false;
+        }
+        depth_sorting = data["depth_sorting"].get<bool>();
+
 
         //output the json again
         ofstream outfile("settings.json");
@@ -60,6 +124,12 @@ private:
     inline static bool initialized = false;
 public:
 
+    json post_processing;//see PostChain
+    json dynamic_resolution;//see DynamicResolution
+    json frame_pacing;//see FramePacer
+    json indexed_color;//see IndexedColor
+    json texture_residency;//see Allocator
+
     class KeybindRegistry {
         private:
         unordered_map<str, keybind> keybindings{};
@@ -119,6 +189,9 @@ public:
         return KeybindRegistry::instance()[id];
     }
 
+    //remembers what every keybind is doing right now, has to be called on the thread raylib polls input on
+    static void captureKeybinds();
+
     static bool validateJsonFile(json& data) {
         if (validateJsonData(data, "keybindings", json::value_t::array)) {
             for (const auto& obj: data["keybindings"].get<vector<json>>()) {
@@ -179,20 +252,38 @@ public:
     }
 };
 
+inline keybind_state capturedKeybind(const keybind& key) {
+    const auto it = captured_keybinds.find(&key);
+    return it == captured_keybinds.end() ? keybind_state{} : it->second;
+}
+
 inline bool IsKeybindDown(const keybind& key) {
+    if (use_captured_keybinds) return capturedKeybind(key).down;
     return IsKeyDown(key.keyboard) || (IsMouseButtonPressed(key.mouse) && key.mouse != -1);
 }
 
 inline bool IsKeybindPressed(const keybind& key) {
+    if (use_captured_keybinds) return capturedKeybind(key).pressed;
     return IsKeyPressed(key.keyboard) || (IsMouseButtonPressed(key.mouse) && key.mouse != -1);
 }
 
 inline bool IsKeybindReleased(const keybind& key) {
+    if (use_captured_keybinds) return capturedKeybind(key).released;
     return IsKeyReleased(key.keyboard) || (IsMouseButtonPressed(key.mouse) && key.mouse != -1);
 }
 
 inline bool IsKeybindUp(const keybind& key) {
+    if (use_captured_keybinds) return capturedKeybind(key).up;
     return IsKeyUp(key.keyboard) || (IsMouseButtonPressed(key.mouse) && key.mouse != -1);
 }
 
+inline void settings::captureKeybinds() {
+    const bool was_captured = use_captured_keybinds;
+    use_captured_keybinds = false;
+    for (auto& k: KeybindRegistry::instance().keybindings | views::values) {
+        captured_keybinds[&k] = {IsKeybindDown(k), IsKeybindPressed(k), IsKeybindReleased(k), IsKeybindUp(k)};
+    }
+    use_captured_keybinds = was_captured;
+}
+
 #endif
@@ -104,8 +104,24 @@ public:
         return false;
     }
 
-    void draw(const dvec2 offset) override {
+    rect bounds() override {
+        const rect sprite_rect = {collision.pos()-dvec2{5, 25}, current_animation->width(), current_animation->height()};
+        //the shadow hangs off the bottom of the collision
+        const rect shadow = {collision.center().x-1-collision.w/2.5, collision.y+collision.h-0.8*collision.h,
+            collision.w/1.25, 1.6*collision.h};
+        return collision | sprite_rect | shadow;
+    }
+
+    void submitShadow(const dvec2 offset) override {
         sprite::drawShadow({collision.center().x-offset.x-1, collision.y+collision.h-offset.y}, collision.w/2.5f, 0.8f*collision.h);
+    }
+
+    bool isTranslucent() override {
+        return current_animation->isTranslucent();
+    }
+
+    void draw(const dvec2 offset) override {
+        IndexedColor::instance().use(current_animation->getTexture());
         DrawAnimation(*current_animation, collision.pos()-offset-dvec2{5, 25});
     }
 };
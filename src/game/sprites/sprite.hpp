@@ -3,6 +3,7 @@
 
 #include "../lib/globals.hpp"
 #include "../lib/JOB.hpp"
+#include "../lib/primitives.hpp"
 
 struct sprite;
 
@@ -110,6 +111,11 @@ public:
         return health <= 0;
     }
 
+    //a sprite can draw anything, so it gets blended in depth order unless it knows what it draws (see player)
+    bool isTranslucent() override {
+        return true;
+    }
+
 
     //should call this in derived types
     void update(seconds_t delta) override {
@@ -123,8 +129,9 @@ public:
         }
     }
 
+    //adds a shadow to PrimitiveBatch::shadows(), call it from submitShadow()
     static void drawShadow(dvec2 pos, float w, float h) {
-        DrawEllipse(EXPAND_V(pos.convert_data<i32>()), w, h, Fade(BLACK, 0.2));
+        PrimitiveBatch::shadows().ellipse(pos.convert_data<i32>().convert_data<double>(), w, h, Fade(BLACK, 0.2));
     }
 };
 
@@ -162,15 +169,16 @@ inline sprite::sprite(spriteSpawnPoint* r) : DynamicLevelObject(r->getCollision(
 struct spriteSpawnPointFactory {
     using factory_type = spriteSpawnPoint;
 
-    NODISCARD static shared_ptr<factory_type> createFromJson(json& data) {
-        if (validateJsonData(data, "position", json::value_t::array)) {
-            auto pos = data["position"].get<vector<double>>();
-            if (pos.size() != 2) {
-                throw Exception("Cannot create type from json data!");
-            }
-            return make_shared<factory_type>(dvec2{pos[0], pos[1]});
-        }
-        return make_shared<factory_type>();
+    struct fields {
+        dvec2 position{};
+    };
+
+    inline static const JsonSchema<fields> schema = JsonSchema<fields>()
+        .field("position", &fields::position);
+
+    NODISCARD static shared_ptr<factory_type> createFromJson(const json& data) {
+        const fields f = schema.read(data);
+        return make_shared<factory_type>(f.position);
     }
 
 
@@ -184,6 +192,18 @@ struct spriteSpawnPointFactory {
     NODISCARD static shared_ptr<factory_type> createDefault() {
         return make_shared<factory_type>();
     }
+
+    struct record {
+        double x, y;
+    };
+
+    NODISCARD static shared_ptr<factory_type> createFromBinary(const record& r, const BinaryLevelFile&) {
+        return make_shared<factory_type>(dvec2{r.x, r.y});
+    }
+
+    NODISCARD static record objectToBinary(LevelObject& x, BinaryLevelWriter&) {
+        return {x.getCollision().x, x.getCollision().y};
+    }
 };
 
 REGISTER(spriteSpawnPoint, "sprite_spawn_point")
@@ -206,15 +226,8 @@ REGISTER(spriteSpawnPoint, "sprite_spawn_point")
                                           };\
                                           struct SPRITE_TYPE##SpawnPointFactory {\
                                               using factory_type = SPRITE_TYPE##SpawnPoint;\
-                                              NODISCARD static shared_ptr<factory_type> createFromJson(json& data) {\
-                                                  if (validateJsonData(data, "position", json::value_t::array)) {\
-                                                      auto pos = data["position"].get<vector<double>>();\
-                                                      if (pos.size() != 2) {\
-                                                          throw Exception("Cannot create type from json data!");\
-                                                      }\
-                                                      return make_shared<factory_type>(dvec2{pos[0], pos[1]});\
-                                                  }\
-                                                  return make_shared<factory_type>();\
+                                              NODISCARD static shared_ptr<factory_type> createFromJson(const json& data) {\
+                                                  return make_shared<factory_type>(spriteSpawnPointFactory::schema.read(data).position);\
                                               }\
                                             NODISCARD static json objectToJson(const LevelObject& x) {\
                                                     json ret;\
@@ -224,6 +237,15 @@ REGISTER(spriteSpawnPoint, "sprite_spawn_point")
                                             NODISCARD static shared_ptr<factory_type> createDefault() {\
                                                 return make_shared<factory_type>();\
                                             }\
+                                            struct record {\
+                                                double x, y;\
+                                            };\
+                                            NODISCARD static shared_ptr<factory_type> createFromBinary(const record& r, const BinaryLevelFile&) {\
+                                                return make_shared<factory_type>(dvec2{r.x, r.y});\
+                                            }\
+                                            NODISCARD static record objectToBinary(LevelObject& x, BinaryLevelWriter&) {\
+                                                return {x.getCollision().x, x.getCollision().y};\
+                                            }\
                                           };\
                                           REGISTER(SPRITE_TYPE##SpawnPoint, ID)\
 
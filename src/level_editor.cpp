@@ -45,6 +45,9 @@ int main(int rargc, char** rargv) {
     if (unordered_set<str>::iterator i; (i = argv.find("--noraylib")) != argv.end()) {
         log_raylib_stuff = false;
     }
+    if (argv.contains("--bake-lightmaps")) {
+        bake_lightmaps_on_load = true;
+    }
     auto LMain = logger("main");
 
     for (const auto &s: LevelObjectRegistry::instance().factories | views::keys) {
@@ -54,50 +57,75 @@ int main(int rargc, char** rargv) {
     INIT(log_raylib_stuff ? LOG_ALL:LOG_NONE);
     MaximizeWindow();
 
-    RenderTexture2D light_texture = Allocator::allocateRenderTexture(base_resolution.x, base_resolution.y);
-
     rlImGuiSetup(true);
-    AnimationRegistry::Instance();
+    //the editor lists every texture and animation, so none of them get loaded on demand
+    Allocator::keepAllTextures();
 
     auto editor = LevelEditor(&running);
     settings::initialize();
     //ensure we pre-process the settings
     settings::instance();
 
-    const Shader post = Allocator::allocateShader(nullptr, "resources/shaders/post.fsh");
+    PostChain::instance().configure(settings::instance().post_processing);
+    DynamicResolution::instance().configure(settings::instance().dynamic_resolution);
+    FramePacer::instance().configure(settings::instance().frame_pacing, true);
+
+    //--convert-level <from> <to> converts a level between json and binary (picked by the extensions) and quits
+    for (int i = 1; i < rargc; i++) {
+        if (strcmp(rargv[i], "--convert-level") != 0) continue;
+        if (i + 2 >= rargc) {
+            LMain.warn("Usage: --convert-level <from> <to>");
+        } else {
+            try {
+                level converted(rargv[i + 1]);
+                converted.save(rargv[i + 2]);
+                LMain.info("Converted ", rargv[i + 1], " to ", rargv[i + 2]);
+            } catch (const exception& e) {
+                LMain.warn("Could not convert ", rargv[i + 1], ": ", e.what());
+            }
+        }
+        Allocator::free();
+        CloseWindow();
+        return 0;
+    }
 
+    HotReload::instance().start();
     while (running) {
 
         if (WindowShouldClose()) {
             editor.levelEditorQuit();
         }
         UPDATE_DELTA_EDITOR();
+        //nothing changed since the last frame, it's still on the screen, so dont draw anything until something happens
+        if (!editor.needsRedraw()) {
+            editor.waitForInput();
+            continue;
+        }
+        DynamicResolution::instance().beginFrame(FramePacer::instance().busyTime());
 
 
         //updates
         editor.update(delta);
 
+        //anything that has to be rendered before the buffer
+        editor.prepareDraw();
 
-        //draw to buffer
-        BeginTextureMode(rbuf);
+        //draw to buffer, at whatever resolution dynamic resolution picked
+        DynamicResolution::instance().beginScene();
 
         //clear the background
         ClearBackground(BLACK);
         //draw the game
         editor.draw();
 
-        EndTextureMode();
-
-        //draw the lighting
-        BeginTextureMode(light_texture);
-        BeginBlendMode(BLEND_CUSTOM);
-        rlSetBlendFactors(RL_ONE, RL_ZERO, RL_FUNC_ADD);
+        DynamicResolution::instance().endScene();
 
-        ClearBackground(BLANK);
-        editor.drawLighting();
-        EndBlendMode();
+        //draw the lighting, it gets composited by the lighting post pass
+        LightingPass::instance().render([&] { editor.drawLighting(); });
 
-        EndTextureMode();
+        //post processing
+        PostChain::instance().setInput("lightmap", LightingPass::instance().texture());
+        const Texture2D& frame = PostChain::instance().apply(rbuf.texture);
 
         //wont work as a macro :/
         //calculate screen scaling
@@ -107,25 +135,26 @@ int main(int rargc, char** rargv) {
 
         //draw to the screen
         BeginDrawing();
-        BeginShaderMode(post);
 
         ClearBackground(BLACK);
 
 
-        DRAW_GAME_CONTENT(rbuf.texture)
-        EndShaderMode();
-
-        DRAW_GAME_CONTENT(light_texture.texture);
+        DRAW_GAME_CONTENT(frame)
 
         rlImGuiBegin();
         editor.drawUI();
         rlImGuiEnd();
+        DynamicResolution::instance().endCpu();
         EndDrawing();
 
-        frame_end = high_resolution_clock::now();
+        //the editor doesnt need to redraw any faster than the cap
+        FramePacer::instance().wait();
     }
 
 
+    HotReload::instance().stop();
+    //a save that's still being written has to finish before the editor closes
+    FileSaver::instance().wait();
     Allocator::free();
     CloseWindow();
 }
\ No newline at end of file
@@ -40,6 +40,15 @@ int main(int rargc, char** rargv) {
     if (unordered_set<str>::iterator i; (i = argv.find("--noraylib")) != argv.end()) {
         log_raylib_stuff = false;
     }
+    if (argv.contains("--bake-lightmaps")) {
+        bake_lightmaps_on_load = true;
+    }
+    //lighting benchmark, 1000 live lights around the start of the level
+    const bool light_stress = argv.contains("--light-stress");
+    //particle benchmark, 100000 live particles around the start of the level
+    const bool particle_stress = argv.contains("--particle-stress");
+    //updates on the main thread like before, to compare against the pipelined frame
+    const bool serial_frames = argv.contains("--serial-frames");
 
     auto LMain = logger("main");
 
@@ -47,6 +56,10 @@ int main(int rargc, char** rargv) {
         LMain.info("Found registered type: ", s);
     }
 
+    //textures and animations come out of the asset pack (see AssetPacker) when there is one, it has to be open before
+    //anything gets loaded, --no-pack loads the loose files instead
+    if (!argv.contains("--no-pack")) AssetPack::instance().open(AssetPack::default_path);
+
     INIT(log_raylib_stuff ? LOG_ALL:LOG_NONE);
 
     auto game = Game();
@@ -54,30 +67,75 @@ int main(int rargc, char** rargv) {
     //ensure we pre-process the settings
     settings::instance();
 
-    const Shader post = Allocator::allocateShader(nullptr, "resources/shaders/post.fsh");
+    //every texture gets reloaded when indexed color is on, so it goes before anything else grabs textures
+    IndexedColor::instance().configure(settings::instance().indexed_color);
+    PostChain::instance().configure(settings::instance().post_processing);
+    DynamicResolution::instance().configure(settings::instance().dynamic_resolution);
+    FramePacer::instance().configure(settings::instance().frame_pacing);
+    Allocator::configure(settings::instance().texture_residency);
+    HotReload::instance().start();
+
+    if (light_stress) game.spawnLightStress(1000);
+    if (particle_stress) game.spawnParticleStress(100000);
+
+    //the update (and the lights it leaves behind) runs on its own thread while the frame before it renders
+    auto& pipeline = FramePipeline::instance();
+    pipeline.start([&game](const double d, RenderCommandList& list) {
+        game.update(d);
+        LightingPass::instance().record(list.lighting, [&] { game.drawLighting(); });
+    }, !serial_frames);
+    use_captured_keybinds = pipeline.threaded();
 
     //the first moment everything is initialized
     game.current_level->start();
     game.beginPlay();
+    //the first frame gets drawn as the level starts out
+    settings::captureKeybinds();
+    pipeline.launch(0);
     while (running) {
 
         UPDATE_DELTA();
+        //judged on the time spent working, otherwise waiting for the frame cap would look like a slow frame
+        DynamicResolution::instance().beginFrame(FramePacer::instance().busyTime());
 
-
-        //updates
+        //wait for this frame's update, nothing in the game changes again until the next launch
+        RenderCommandList& frame_list = pipeline.sync();
         game.update_fps(delta);
-        game.update(delta);
 
+        //files that changed get reloaded and textures the level started using get loaded, nothing can be grabbing
+        //animations until the next launch
+        game.hotReload(HotReload::instance().update());
+        game.updateLoading(level::load_budget_ms);
+        AnimationRegistry::Instance().updateResidency();
+        if (Allocator::uploadTextures(TextureStreamer::upload_budget_ms) && game.current_level) {
+            game.current_level->invalidateStaticLayer();
+        }
+
+        //anything that has to be rendered before the buffer
+        game.prepareDraw();
 
-        //draw to buffer
-        BeginTextureMode(rbuf);
+        //draw to buffer, at whatever resolution dynamic resolution picked
+        DynamicResolution::instance().beginScene();
 
         //clear the background
         ClearBackground(BLACK);
         //draw the game
         game.draw();
 
-        EndTextureMode();
+        DynamicResolution::instance().endScene();
+        game.recordUI(frame_list.ui);
+
+        //the next frame updates while this one renders
+        settings::captureKeybinds();
+        pipeline.launch(delta);
+        pipeline.beginRender();
+
+        //draw the lighting, it gets composited by the lighting post pass
+        LightingPass::instance().render(frame_list.lighting);
+
+        //post processing
+        PostChain::instance().setInput("lightmap", LightingPass::instance().texture());
+        const Texture2D& frame = PostChain::instance().apply(rbuf.texture);
 
         //wont work as a macro :/
         //calculate screen scaling
@@ -87,21 +145,26 @@ int main(int rargc, char** rargv) {
 
         //draw to the screen
         BeginDrawing();
-        BeginShaderMode(post);
 
         ClearBackground(BLACK);
 
 
-        DRAW_GAME_CONTENT(rbuf.texture)
+        DRAW_GAME_CONTENT(frame)
 
-        EndShaderMode();
+        frame_list.drawUI();
+        DynamicResolution::instance().endCpu();
         EndDrawing();
+        pipeline.endRender();
 
-        frame_end = high_resolution_clock::now();
+        //hold the frame to the target frame rate, the next update keeps running while this waits
+        FramePacer::instance().wait();
     }
+    //the update still running has to finish before anything goes away
+    pipeline.sync();
     //the last moment that game objects are initialized
     game.endPlay();
 
+    HotReload::instance().stop();
     Allocator::free();
     CloseWindow();
 }
\ No newline at end of file